@@ -0,0 +1,66 @@
+#include "MotionClockSync.h"
+
+void FMotionClockSync::AddSample(double ClientSendTime, double ServerTime, double ClientReceiveTime)
+{
+	const double RoundTripTime = ClientReceiveTime - ClientSendTime;
+	if (RoundTripTime < 0.0)
+	{
+		return;
+	}
+
+	FMotionClockSample& Sample = Samples[NumSamples % FilterSize];
+	Sample.LocalTime = ClientReceiveTime;
+	Sample.Offset = ServerTime + RoundTripTime * 0.5 - ClientReceiveTime;
+	Sample.RoundTripTime = RoundTripTime;
+	++NumSamples;
+
+	const FMotionClockSample* Best = &Samples[0];
+	for (int32 i = 1; i < FMath::Min(NumSamples, FilterSize); ++i)
+	{
+		if (Samples[i].RoundTripTime < Best->RoundTripTime)
+		{
+			Best = &Samples[i];
+		}
+	}
+
+	// a sample can stay the best one for a while, it only counts once
+	if (bIsSynchronized && Best->LocalTime <= BaseLocalTime)
+	{
+		return;
+	}
+
+	const double Predicted = BaseOffset + Drift * (Best->LocalTime - BaseLocalTime);
+	const double Error = Best->Offset - Predicted;
+	if (!bIsSynchronized || FMath::Abs(Error) > StepThreshold)
+	{
+		BaseOffset = Best->Offset;
+		Drift = 0.0;
+		bIsSynchronized = true;
+	}
+	else
+	{
+		const double Elapsed = Best->LocalTime - BaseLocalTime;
+		if (Elapsed > KINDA_SMALL_NUMBER)
+		{
+			Drift = FMath::Clamp(Drift + Error / Elapsed * DriftGain, -MaxDrift, MaxDrift);
+		}
+		BaseOffset = Predicted + Error * OffsetGain;
+	}
+	BaseLocalTime = Best->LocalTime;
+	BaseRoundTripTime = Best->RoundTripTime;
+}
+
+void FMotionClockSync::Reset()
+{
+	NumSamples = 0;
+	bIsSynchronized = false;
+	BaseLocalTime = 0.0;
+	BaseOffset = 0.0;
+	BaseRoundTripTime = 0.0;
+	Drift = 0.0;
+}
+
+double FMotionClockSync::GetServerTime(double LocalTime) const
+{
+	return LocalTime + BaseOffset + Drift * (LocalTime - BaseLocalTime);
+}
@@ -0,0 +1,210 @@
+#include "MotionInterpolationBatch.h"
+
+void FMotionInterpolationBatch::Reset(int32 InNumSegments)
+{
+	NumSegments = InNumSegments;
+	SegmentModes.Reset();
+	SegmentModes.SetNumZeroed(NumSegments);
+
+	// whole registers are processed, lanes past the last segment only see stale or zeroed values
+	const int32 NumPadded = Align(NumSegments, 4);
+	const auto Grow = [NumPadded](FChannel& Channel)
+	{
+		if (Channel.Num() < NumPadded)
+		{
+			Channel.SetNumZeroed(NumPadded);
+		}
+	};
+	for (int32 c = 0; c < NumChannels; ++c)
+	{
+		Grow(First[c]);
+		Grow(Second[c]);
+		Grow(Result[c]);
+	}
+	Grow(TargetTimes);
+	Grow(HermiteMask);
+	Grow(Alphas);
+	if (BaseTimes.Num() < NumPadded)
+	{
+		BaseTimes.SetNumZeroed(NumPadded);
+	}
+}
+
+void FMotionInterpolationBatch::SetChannels(FChannel* Channels, int32 Index, const FMotionSnapshot& Snapshot)
+{
+	Channels[LocationX][Index] = Snapshot.Location.X;
+	Channels[LocationY][Index] = Snapshot.Location.Y;
+	Channels[LocationZ][Index] = Snapshot.Location.Z;
+	Channels[Pitch][Index] = Snapshot.Rotation.Pitch;
+	Channels[Yaw][Index] = Snapshot.Rotation.Yaw;
+	Channels[Roll][Index] = Snapshot.Rotation.Roll;
+	Channels[VelocityX][Index] = Snapshot.Velocity.X;
+	Channels[VelocityY][Index] = Snapshot.Velocity.Y;
+	Channels[VelocityZ][Index] = Snapshot.Velocity.Z;
+	Channels[AngularVelocityX][Index] = Snapshot.AngularVelocity.X;
+	Channels[AngularVelocityY][Index] = Snapshot.AngularVelocity.Y;
+	Channels[AngularVelocityZ][Index] = Snapshot.AngularVelocity.Z;
+}
+
+void FMotionInterpolationBatch::SetChannels(FChannel* Channels, int32 Index, const FMotionBufferedSnapshot& Entry)
+{
+	Channels[LocationX][Index] = Entry.Location.X;
+	Channels[LocationY][Index] = Entry.Location.Y;
+	Channels[LocationZ][Index] = Entry.Location.Z;
+	Channels[Pitch][Index] = Entry.Rotation.Pitch;
+	Channels[Yaw][Index] = Entry.Rotation.Yaw;
+	Channels[Roll][Index] = Entry.Rotation.Roll;
+	Channels[VelocityX][Index] = Entry.Velocity[0].GetFloat();
+	Channels[VelocityY][Index] = Entry.Velocity[1].GetFloat();
+	Channels[VelocityZ][Index] = Entry.Velocity[2].GetFloat();
+	Channels[AngularVelocityX][Index] = Entry.AngularVelocity[0].GetFloat();
+	Channels[AngularVelocityY][Index] = Entry.AngularVelocity[1].GetFloat();
+	Channels[AngularVelocityZ][Index] = Entry.AngularVelocity[2].GetFloat();
+}
+
+void FMotionInterpolationBatch::SetSegment(int32 Index, const FMotionSnapshot& InFirst, const FMotionSnapshot& InSecond, double TargetTime, EMotionInterpolationMode Mode)
+{
+	check(Index >= 0 && Index < NumSegments);
+	SetChannels(First, Index, InFirst);
+	SetChannels(Second, Index, InSecond);
+	SetSegmentTimes(Index, InFirst.Timestamp, InSecond.Timestamp, TargetTime, Mode);
+}
+
+void FMotionInterpolationBatch::SetSegment(int32 Index, const FMotionBufferedSnapshot& InFirst, const FMotionBufferedSnapshot& InSecond, double TargetTime, EMotionInterpolationMode Mode)
+{
+	check(Index >= 0 && Index < NumSegments);
+	SetChannels(First, Index, InFirst);
+	SetChannels(Second, Index, InSecond);
+	SetSegmentTimes(Index, InFirst.Timestamp, InSecond.Timestamp, TargetTime, Mode);
+}
+
+void FMotionInterpolationBatch::SetSegmentTimes(int32 Index, double FirstTime, double SecondTime, double TargetTime, EMotionInterpolationMode Mode)
+{
+	BaseTimes[Index] = FirstTime;
+	First[Timestamp][Index] = 0.0f;
+	Second[Timestamp][Index] = static_cast<float>(SecondTime - FirstTime);
+	TargetTimes[Index] = static_cast<float>(TargetTime - FirstTime);
+	HermiteMask[Index] = Mode == EMotionInterpolationMode::Hermite ? 1.0f : 0.0f;
+	SegmentModes[Index] = static_cast<uint8>(Mode) + 1;
+}
+
+void FMotionInterpolationBatch::Interpolate()
+{
+	const VectorRegister Zero = VectorZero();
+	const VectorRegister One = VectorOne();
+	const VectorRegister Half = VectorSetFloat1(0.5f);
+	const VectorRegister Two = VectorSetFloat1(2.0f);
+	const VectorRegister Three = VectorSetFloat1(3.0f);
+	const VectorRegister Four = VectorSetFloat1(4.0f);
+	const VectorRegister Six = VectorSetFloat1(6.0f);
+	const VectorRegister Pi = VectorSetFloat1(PI);
+	const VectorRegister HalfTurn = VectorSetFloat1(180.0f);
+	const VectorRegister FullTurn = VectorSetFloat1(360.0f);
+	const VectorRegister MinDuration = VectorSetFloat1(KINDA_SMALL_NUMBER);
+
+	const int32 NumPadded = Align(NumSegments, 4);
+	for (int32 i = 0; i < NumPadded; i += 4)
+	{
+		const VectorRegister TargetTime = VectorLoadAligned(&TargetTimes[i]);
+		const VectorRegister FirstTime = VectorLoadAligned(&First[Timestamp][i]);
+		const VectorRegister SecondTime = VectorLoadAligned(&Second[Timestamp][i]);
+		const VectorRegister IsHermite = VectorCompareGT(VectorLoadAligned(&HermiteMask[i]), Half);
+
+		const VectorRegister Duration = VectorSubtract(SecondTime, FirstTime);
+		const VectorRegister HasDuration = VectorCompareGT(Duration, MinDuration);
+		const VectorRegister ForwardTime = VectorSubtract(TargetTime, FirstTime);
+		const VectorRegister BackwardTime = VectorSubtract(TargetTime, SecondTime);
+		// segments only hold target times strictly between their snapshots, the clamp is what Hermite does for the rest
+		const VectorRegister Alpha = VectorSelect(HasDuration, VectorMin(VectorMax(VectorDivide(ForwardTime, Duration), Zero), One), One);
+		const VectorRegister InvDuration = VectorSelect(HasDuration, VectorDivide(One, Duration), Zero);
+		VectorStoreAligned(Alpha, &Alphas[i]);
+
+		// cubic Hermite basis and its derivative
+		const VectorRegister Alpha2 = VectorMultiply(Alpha, Alpha);
+		const VectorRegister Alpha3 = VectorMultiply(Alpha2, Alpha);
+		const VectorRegister H00 = VectorAdd(VectorSubtract(VectorMultiply(Two, Alpha3), VectorMultiply(Three, Alpha2)), One);
+		const VectorRegister H10 = VectorAdd(VectorSubtract(Alpha3, VectorMultiply(Two, Alpha2)), Alpha);
+		const VectorRegister H01 = VectorSubtract(VectorMultiply(Three, Alpha2), VectorMultiply(Two, Alpha3));
+		const VectorRegister H11 = VectorSubtract(Alpha3, Alpha2);
+		const VectorRegister D00 = VectorSubtract(VectorMultiply(Six, Alpha2), VectorMultiply(Six, Alpha));
+		const VectorRegister D10 = VectorAdd(VectorSubtract(VectorMultiply(Three, Alpha2), VectorMultiply(Four, Alpha)), One);
+		const VectorRegister D01 = VectorNegate(D00);
+		const VectorRegister D11 = VectorSubtract(VectorMultiply(Three, Alpha2), VectorMultiply(Two, Alpha));
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const VectorRegister P0 = VectorLoadAligned(&First[LocationX + Axis][i]);
+			const VectorRegister P1 = VectorLoadAligned(&Second[LocationX + Axis][i]);
+			const VectorRegister V0 = VectorLoadAligned(&First[VelocityX + Axis][i]);
+			const VectorRegister V1 = VectorLoadAligned(&Second[VelocityX + Axis][i]);
+			const VectorRegister W0 = VectorLoadAligned(&First[AngularVelocityX + Axis][i]);
+			const VectorRegister W1 = VectorLoadAligned(&Second[AngularVelocityX + Axis][i]);
+
+			// PredictionBlend: lerp between the forward prediction of the first and the backward prediction of the second snapshot
+			const VectorRegister Forward = VectorMultiplyAdd(V0, ForwardTime, P0);
+			const VectorRegister Backward = VectorMultiplyAdd(V1, BackwardTime, P1);
+			const VectorRegister BlendLocation = VectorMultiplyAdd(VectorSubtract(Backward, Forward), Alpha, Forward);
+			const VectorRegister BlendVelocity = VectorMultiplyAdd(VectorSubtract(V1, V0), Alpha, V0);
+
+			// Hermite: tangents are the velocities scaled to the normalized segment
+			const VectorRegister M0 = VectorMultiply(V0, Duration);
+			const VectorRegister M1 = VectorMultiply(V1, Duration);
+			const VectorRegister HermiteLocation = VectorMultiplyAdd(H11, M1, VectorMultiplyAdd(H01, P1, VectorMultiplyAdd(H10, M0, VectorMultiply(H00, P0))));
+			const VectorRegister Derivative = VectorMultiplyAdd(D11, M1, VectorMultiplyAdd(D01, P1, VectorMultiplyAdd(D10, M0, VectorMultiply(D00, P0))));
+			const VectorRegister HermiteVelocity = VectorSelect(HasDuration, VectorMultiply(Derivative, InvDuration), V1);
+
+			VectorStoreAligned(VectorSelect(IsHermite, HermiteLocation, BlendLocation), &Result[LocationX + Axis][i]);
+			VectorStoreAligned(VectorSelect(IsHermite, HermiteVelocity, BlendVelocity), &Result[VelocityX + Axis][i]);
+			VectorStoreAligned(VectorMultiplyAdd(VectorSubtract(W1, W0), Alpha, W0), &Result[AngularVelocityX + Axis][i]);
+		}
+
+		// PredictionBlend rotation: FMath::Lerp of the rotators eased by InterpSinInOut, which is 0.5 - 0.5 cos(pi alpha)
+		const VectorRegister EasedAlpha = VectorSubtract(Half, VectorMultiply(Half, VectorCos(VectorMultiply(Pi, Alpha))));
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const VectorRegister R0 = VectorLoadAligned(&First[Pitch + Axis][i]);
+			const VectorRegister R1 = VectorLoadAligned(&Second[Pitch + Axis][i]);
+			// FRotator::NormalizeAxis of the difference, so the shortest way around is taken
+			VectorRegister Delta = VectorMod(VectorSubtract(R1, R0), FullTurn);
+			Delta = VectorSelect(VectorCompareGT(Zero, Delta), VectorAdd(Delta, FullTurn), Delta);
+			Delta = VectorSelect(VectorCompareGT(Delta, HalfTurn), VectorSubtract(Delta, FullTurn), Delta);
+			VectorStoreAligned(VectorMultiplyAdd(Delta, EasedAlpha, R0), &Result[Pitch + Axis][i]);
+		}
+
+		VectorStoreAligned(TargetTime, &Result[Timestamp][i]);
+	}
+
+	// Hermite rotations blend two quaternion predictions, see UMotionInterpolatorComponent::HermiteInterpolate
+	const uint8 HermiteMode = static_cast<uint8>(EMotionInterpolationMode::Hermite) + 1;
+	for (int32 i = 0; i < NumSegments; ++i)
+	{
+		if (SegmentModes[i] != HermiteMode)
+		{
+			continue;
+		}
+		const float Alpha = Alphas[i];
+		const float Duration = Second[Timestamp][i] - First[Timestamp][i];
+		const FQuat FirstRotation = FRotator(First[Pitch][i], First[Yaw][i], First[Roll][i]).Quaternion();
+		const FQuat SecondRotation = FRotator(Second[Pitch][i], Second[Yaw][i], Second[Roll][i]).Quaternion();
+		const FVector FirstAngularVelocity(First[AngularVelocityX][i], First[AngularVelocityY][i], First[AngularVelocityZ][i]);
+		const FVector SecondAngularVelocity(Second[AngularVelocityX][i], Second[AngularVelocityY][i], Second[AngularVelocityZ][i]);
+
+		const FQuat ForwardPrediction = UMotionInterpolatorComponent::IntegrateAngularVelocity(FirstRotation, FirstAngularVelocity, Alpha * Duration);
+		const FQuat BackwardPrediction = UMotionInterpolatorComponent::IntegrateAngularVelocity(SecondRotation, SecondAngularVelocity, (Alpha - 1.0f) * Duration);
+		const FRotator Rotation = FQuat::Slerp(ForwardPrediction, BackwardPrediction, FMath::SmoothStep(0.0f, 1.0f, Alpha)).Rotator();
+		Result[Pitch][i] = Rotation.Pitch;
+		Result[Yaw][i] = Rotation.Yaw;
+		Result[Roll][i] = Rotation.Roll;
+	}
+}
+
+FMotionSnapshot FMotionInterpolationBatch::GetResult(int32 Index) const
+{
+	FMotionSnapshot Snapshot;
+	Snapshot.Location = FVector(Result[LocationX][Index], Result[LocationY][Index], Result[LocationZ][Index]);
+	Snapshot.Rotation = FRotator(Result[Pitch][Index], Result[Yaw][Index], Result[Roll][Index]);
+	Snapshot.Velocity = FVector(Result[VelocityX][Index], Result[VelocityY][Index], Result[VelocityZ][Index]);
+	Snapshot.AngularVelocity = FVector(Result[AngularVelocityX][Index], Result[AngularVelocityY][Index], Result[AngularVelocityZ][Index]);
+	Snapshot.Timestamp = BaseTimes[Index] + Result[Timestamp][Index];
+	return Snapshot;
+}
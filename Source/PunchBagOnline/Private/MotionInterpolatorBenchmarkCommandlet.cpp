@@ -0,0 +1,541 @@
+#include "MotionInterpolatorBenchmarkCommandlet.h"
+#include "MotionInterpolatorComponent.h"
+#include "MotionInterpolatorSubsystem.h"
+#include "MotionSyncChannelComponent.h"
+#include "MotionSnapshotCodec.h"
+#include "MotionInterpolationBatch.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformProcess.h"
+#include "PunchBagOnline.h"
+
+namespace MotionInterpolatorBenchmark
+{
+	struct FSettings
+	{
+		int32 NumActors = 128;
+		float Duration = 10.0f;
+		float Warmup = 1.0f;
+		float TickRate = 60.0f;
+		float SendPeriod = 0.05f;
+		/** Milliseconds, like the net driver's PktLag and PktLagVariance */
+		float Lag = 100.0f;
+		float LagVariance = 20.0f;
+		/** Percent, like PktLoss */
+		float Loss = 2.0f;
+		int32 Seed = 0;
+		/** Same split as UMotionSyncChannelComponent::MaxSnapshotsPerBatch */
+		int32 MaxSnapshotsPerBatch = 32;
+		EMotionPrecisionProfile PrecisionProfile = EMotionPrecisionProfile::Default;
+		EMotionInterpolationMode InterpolationMode = EMotionInterpolationMode::PredictionBlend;
+		FString OutputPath;
+	};
+
+	struct FSyncedActor
+	{
+		UMotionInterpolatorComponent* Interpolator = nullptr;
+		USceneComponent* Root = nullptr;
+		FVector Center = FVector::ZeroVector;
+		float Phase = 0.0f;
+		FMotionSnapshotSendStream SendStream;
+		FMotionSnapshotReceiveStream ReceiveStream;
+	};
+
+	/** Serialized FMotionSnapshotBatch, only the written bits travel */
+	struct FSimulatedPacket
+	{
+		double DeliveryTime = 0.0;
+		TArray<uint8> Data;
+		int64 NumBits = 0;
+
+		void Write(FMotionSnapshotBatch& Batch)
+		{
+			FBitWriter Writer(0, true);
+			bool bSuccess = true;
+			Batch.NetSerialize(Writer, nullptr, bSuccess);
+			Data = *Writer.GetBuffer();
+			NumBits = Writer.GetNumBits();
+		}
+
+		bool Read(FMotionSnapshotBatch& OutBatch)
+		{
+			FBitReader Reader(Data.GetData(), NumBits);
+			bool bSuccess = true;
+			OutBatch.NetSerialize(Reader, nullptr, bSuccess);
+			return bSuccess && !Reader.IsError();
+		}
+	};
+
+	/** Ground truth: circles with a vertical bob while turning around */
+	static FMotionSnapshot GetScriptedMotion(const FVector& Center, float Phase, double Time)
+	{
+		static constexpr float Radius = 300.0f;
+		static constexpr float Height = 50.0f;
+		static constexpr float Speed = 1.0f;
+
+		// wrapped in doubles, floats would lose the phase after a while
+		const double Turns = Time * Speed / (2.0 * PI);
+		const float Angle = Phase + static_cast<float>((Turns - FMath::FloorToDouble(Turns)) * 2.0 * PI);
+		FMotionSnapshot Result;
+		Result.Location = Center + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, FMath::Sin(2.0f * Angle) * Height);
+		Result.Velocity = FVector(-FMath::Sin(Angle) * Radius * Speed, FMath::Cos(Angle) * Radius * Speed, 2.0f * FMath::Cos(2.0f * Angle) * Height * Speed);
+		Result.Rotation = FRotator(0.0f, FRotator::NormalizeAxis(FMath::RadiansToDegrees(Angle)), 0.0f);
+		Result.AngularVelocity = FVector(0.0f, 0.0f, FMath::RadiansToDegrees(Speed));
+		Result.Timestamp = Time;
+		return Result;
+	}
+
+	static FSettings ParseSettings(const FString& Params)
+	{
+		FSettings Settings;
+		FParse::Value(*Params, TEXT("Actors="), Settings.NumActors);
+		FParse::Value(*Params, TEXT("Duration="), Settings.Duration);
+		FParse::Value(*Params, TEXT("Warmup="), Settings.Warmup);
+		FParse::Value(*Params, TEXT("TickRate="), Settings.TickRate);
+		FParse::Value(*Params, TEXT("SendPeriod="), Settings.SendPeriod);
+		FParse::Value(*Params, TEXT("PktLag="), Settings.Lag);
+		FParse::Value(*Params, TEXT("PktLagVariance="), Settings.LagVariance);
+		FParse::Value(*Params, TEXT("PktLoss="), Settings.Loss);
+		FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+		FParse::Value(*Params, TEXT("MaxSnapshotsPerBatch="), Settings.MaxSnapshotsPerBatch);
+
+		FString ProfileName;
+		if (FParse::Value(*Params, TEXT("Precision="), ProfileName))
+		{
+			const int64 Profile = StaticEnum<EMotionPrecisionProfile>()->GetValueByNameString(ProfileName);
+			if (Profile != INDEX_NONE)
+			{
+				Settings.PrecisionProfile = static_cast<EMotionPrecisionProfile>(Profile);
+			}
+		}
+
+		FString ModeName;
+		if (FParse::Value(*Params, TEXT("Interpolation="), ModeName))
+		{
+			const int64 Mode = StaticEnum<EMotionInterpolationMode>()->GetValueByNameString(ModeName);
+			if (Mode != INDEX_NONE)
+			{
+				Settings.InterpolationMode = static_cast<EMotionInterpolationMode>(Mode);
+			}
+		}
+
+		if (!FParse::Value(*Params, TEXT("Output="), Settings.OutputPath))
+		{
+			Settings.OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), TEXT("MotionInterpolator.json"));
+		}
+
+		Settings.NumActors = FMath::Clamp(Settings.NumActors, 1, MAX_uint16 - 1);
+		Settings.TickRate = FMath::Max(Settings.TickRate, 1.0f);
+		Settings.SendPeriod = FMath::Max(Settings.SendPeriod, 0.001f);
+		Settings.MaxSnapshotsPerBatch = FMath::Clamp(Settings.MaxSnapshotsPerBatch, 1, 255);
+		return Settings;
+	}
+
+	static double GetPercentile(const TArray<double>& SortedValues, double Percentile)
+	{
+		if (SortedValues.Num() == 0)
+		{
+			return 0.0;
+		}
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+		return SortedValues[Index];
+	}
+
+	static TSharedRef<FJsonObject> MakeDistribution(TArray<double>& Values)
+	{
+		Values.Sort();
+		double Sum = 0.0;
+		for (double Value : Values)
+		{
+			Sum += Value;
+		}
+
+		TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+		Result->SetNumberField(TEXT("mean"), Values.Num() > 0 ? Sum / Values.Num() : 0.0);
+		Result->SetNumberField(TEXT("p50"), GetPercentile(Values, 0.5));
+		Result->SetNumberField(TEXT("p95"), GetPercentile(Values, 0.95));
+		Result->SetNumberField(TEXT("p99"), GetPercentile(Values, 0.99));
+		Result->SetNumberField(TEXT("max"), Values.Num() > 0 ? Values.Last() : 0.0);
+		return Result;
+	}
+}
+
+namespace MotionInterpolatorBenchmark
+{
+	/**
+	 * Throughput of FMotionInterpolationBatch against UMotionInterpolatorComponent::Interpolate on the same segments, no world involved.
+	 * Batch times include writing the segments into the batch and reading the results back.
+	 */
+	static TSharedRef<FJsonObject> RunKernelBenchmark(const FSettings& Settings, int32 Iterations)
+	{
+		static const int32 ObjectCounts[] = { 1000, 2500, 5000, 10000 };
+
+		UMotionInterpolatorComponent* Interpolator = NewObject<UMotionInterpolatorComponent>(GetTransientPackage());
+		Interpolator->InterpolationMode = Settings.InterpolationMode;
+
+		FRandomStream Random(Settings.Seed);
+		FMotionInterpolationBatch Batch;
+		TArray<TSharedPtr<FJsonValue>> Runs;
+		for (int32 NumObjects : ObjectCounts)
+		{
+			TArray<FMotionSnapshot> FirstSnapshots;
+			TArray<FMotionSnapshot> SecondSnapshots;
+			TArray<double> TargetTimes;
+			for (int32 i = 0; i < NumObjects; ++i)
+			{
+				const FVector Center = Random.GetUnitVector() * 10000.0f;
+				const float Phase = Random.FRandRange(0.0f, 2.0f * PI);
+				const double Time = Random.FRandRange(0.0f, 100.0f);
+				FirstSnapshots.Add(GetScriptedMotion(Center, Phase, Time));
+				SecondSnapshots.Add(GetScriptedMotion(Center, Phase, Time + Settings.SendPeriod));
+				TargetTimes.Add(FMath::Lerp(FirstSnapshots.Last().Timestamp, SecondSnapshots.Last().Timestamp, Random.FRandRange(0.01f, 0.99f)));
+			}
+
+			TArray<FMotionSnapshot> ScalarResults;
+			ScalarResults.SetNum(NumObjects);
+			const double ScalarStart = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				for (int32 i = 0; i < NumObjects; ++i)
+				{
+					ScalarResults[i] = Interpolator->Interpolate(FirstSnapshots[i], SecondSnapshots[i], TargetTimes[i]);
+				}
+			}
+			const double ScalarTime = FPlatformTime::Seconds() - ScalarStart;
+
+			TArray<FMotionSnapshot> BatchResults;
+			BatchResults.SetNum(NumObjects);
+			const double BatchStart = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Batch.Reset(NumObjects);
+				for (int32 i = 0; i < NumObjects; ++i)
+				{
+					Batch.SetSegment(i, FirstSnapshots[i], SecondSnapshots[i], TargetTimes[i], Settings.InterpolationMode);
+				}
+				Batch.Interpolate();
+				for (int32 i = 0; i < NumObjects; ++i)
+				{
+					BatchResults[i] = Batch.GetResult(i);
+				}
+			}
+			const double BatchTime = FPlatformTime::Seconds() - BatchStart;
+
+			double MaxLocationError = 0.0;
+			double MaxVelocityError = 0.0;
+			double MaxRotationError = 0.0;
+			for (int32 i = 0; i < NumObjects; ++i)
+			{
+				MaxLocationError = FMath::Max<double>(MaxLocationError, FVector::Dist(ScalarResults[i].Location, BatchResults[i].Location));
+				MaxVelocityError = FMath::Max<double>(MaxVelocityError, FVector::Dist(ScalarResults[i].Velocity, BatchResults[i].Velocity));
+				MaxRotationError = FMath::Max<double>(MaxRotationError, FMath::RadiansToDegrees(ScalarResults[i].Rotation.Quaternion().AngularDistance(BatchResults[i].Rotation.Quaternion())));
+			}
+
+			const double NumSegments = static_cast<double>(NumObjects) * Iterations;
+			TSharedRef<FJsonObject> Run = MakeShared<FJsonObject>();
+			Run->SetNumberField(TEXT("objects"), NumObjects);
+			Run->SetNumberField(TEXT("scalar_ns_per_object"), ScalarTime * 1.0e9 / NumSegments);
+			Run->SetNumberField(TEXT("batch_ns_per_object"), BatchTime * 1.0e9 / NumSegments);
+			Run->SetNumberField(TEXT("speedup"), BatchTime > 0.0 ? ScalarTime / BatchTime : 0.0);
+			Run->SetNumberField(TEXT("max_location_error"), MaxLocationError);
+			Run->SetNumberField(TEXT("max_velocity_error"), MaxVelocityError);
+			Run->SetNumberField(TEXT("max_rotation_error_deg"), MaxRotationError);
+			Runs.Add(MakeShared<FJsonValueObject>(Run));
+		}
+
+		TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+		Report->SetStringField(TEXT("interpolation_mode"), StaticEnum<EMotionInterpolationMode>()->GetNameStringByValue(static_cast<int64>(Settings.InterpolationMode)));
+		Report->SetNumberField(TEXT("iterations"), Iterations);
+		Report->SetArrayField(TEXT("runs"), Runs);
+		return Report;
+	}
+}
+
+UMotionInterpolatorBenchmarkCommandlet::UMotionInterpolatorBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+void UMotionInterpolatorBenchmarkCommandlet::HandleNotEnoughData()
+{
+	++NumUnderruns;
+}
+
+int32 UMotionInterpolatorBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace MotionInterpolatorBenchmark;
+
+	const FSettings Settings = ParseSettings(Params);
+
+	if (FParse::Param(*Params, TEXT("Kernel")))
+	{
+		int32 Iterations = 200;
+		FParse::Value(*Params, TEXT("Iterations="), Iterations);
+
+		FString ReportString;
+		const TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&ReportString);
+		FJsonSerializer::Serialize(RunKernelBenchmark(Settings, FMath::Max(Iterations, 1)), JsonWriter);
+		if (!FFileHelper::SaveStringToFile(ReportString, *Settings.OutputPath))
+		{
+			UE_LOG(LogMotionInterpolator, Error, TEXT("Failed to write the benchmark report to %s"), *Settings.OutputPath);
+			return 1;
+		}
+		UE_LOG(LogMotionInterpolator, Display, TEXT("%s"), *ReportString);
+		return 0;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("MotionInterpolatorBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	const FURL URL;
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+
+	UMotionInterpolatorSubsystem* Subsystem = World->GetSubsystem<UMotionInterpolatorSubsystem>();
+	if (!IsValid(Subsystem))
+	{
+		UE_LOG(LogMotionInterpolator, Error, TEXT("No UMotionInterpolatorSubsystem in the benchmark world"));
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		return 1;
+	}
+
+	// simulated proxies only interpolate what they receive
+	TArray<FSyncedActor> Actors;
+	Actors.SetNum(Settings.NumActors);
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Settings.NumActors)));
+	for (int32 i = 0; i < Settings.NumActors; ++i)
+	{
+		FSyncedActor& Synced = Actors[i];
+		Synced.Center = FVector((i % GridSize) * 1000.0f, (i / GridSize) * 1000.0f, 0.0f);
+		Synced.Phase = FMath::Fmod(i * 0.37f, 2.0f * PI);
+
+		AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Synced.Center));
+		Actor->SetRole(ROLE_SimulatedProxy);
+
+		Synced.Root = NewObject<USceneComponent>(Actor, TEXT("Root"));
+		Synced.Root->SetMobility(EComponentMobility::Movable);
+		Actor->SetRootComponent(Synced.Root);
+		Synced.Root->RegisterComponent();
+
+		Synced.Interpolator = NewObject<UMotionInterpolatorComponent>(Actor, TEXT("MotionInterpolator"));
+		Synced.Interpolator->SnapPeriod = 0.0f;
+		Synced.Interpolator->SyncPeriod = Settings.SendPeriod;
+		Synced.Interpolator->PrecisionProfile = Settings.PrecisionProfile;
+		Synced.Interpolator->InterpolationMode = Settings.InterpolationMode;
+		Synced.Interpolator->OnNotEnoughData.AddDynamic(this, &UMotionInterpolatorBenchmarkCommandlet::HandleNotEnoughData);
+		Synced.Interpolator->RegisterComponent();
+	}
+
+	FRandomStream Random(Settings.Seed);
+	const auto GetPacketDelay = [&Settings, &Random]()
+	{
+		return FMath::Max(0.0f, Settings.Lag + Random.FRandRange(-Settings.LagVariance, Settings.LagVariance)) * 0.001;
+	};
+	const auto IsPacketLost = [&Settings, &Random]()
+	{
+		return Random.FRand() * 100.0f < Settings.Loss;
+	};
+
+	TArray<FSimulatedPacket> ToReceiver;
+	TArray<FSimulatedPacket> ToSender;
+	TArray<double> TickTimes;
+	TArray<double> LocationErrors;
+	TArray<double> RotationErrors;
+	int64 SentBits = 0;
+	int32 NumBatches = 0;
+	int32 NumLostBatches = 0;
+
+	const double DeltaTime = 1.0 / Settings.TickRate;
+	const double StartTime = Subsystem->GetLocalClockTime();
+	const double MeasureTime = StartTime + Settings.Warmup;
+	const double EndTime = MeasureTime + Settings.Duration;
+	double NextSendTime = StartTime;
+	bool bIsMeasuring = false;
+
+	UE_LOG(LogMotionInterpolator, Display, TEXT("Motion interpolator benchmark: %d actors, %.0f Hz tick, %.3f s send period, %.0f+-%.0f ms lag, %.1f%% loss"),
+		Settings.NumActors, Settings.TickRate, Settings.SendPeriod, Settings.Lag, Settings.LagVariance, Settings.Loss);
+
+	for (double Now = StartTime; Now < EndTime; Now = Subsystem->GetLocalClockTime())
+	{
+		const double FrameStart = FPlatformTime::Seconds();
+		if (!bIsMeasuring && Now >= MeasureTime)
+		{
+			bIsMeasuring = true;
+			NumUnderruns = 0;
+		}
+
+		// sender: every actor once per send period, encoded by the channel's send streams and split into batches like UMotionSyncChannelComponent does
+		for (int32 First = 0; Now >= NextSendTime && First < Actors.Num(); First += Settings.MaxSnapshotsPerBatch)
+		{
+			const int32 Last = FMath::Min(First + Settings.MaxSnapshotsPerBatch, Actors.Num());
+			FMotionSnapshotBatch Batch;
+			Batch.Entries.SetNum(Last - First);
+			for (int32 i = First; i < Last; ++i)
+			{
+				FSyncedActor& Synced = Actors[i];
+				const FMotionSnapshot Snapshot = GetScriptedMotion(Synced.Center, Synced.Phase, Now);
+				const FQuantizedMotionSnapshot Quantized = FQuantizedMotionSnapshot::Quantize(Snapshot, Synced.Interpolator->GetSnapshotPrecision());
+				Synced.SendStream.Encode(static_cast<uint16>(i + 1), Quantized, Snapshot.AuthorityEpoch, true, Batch.Entries[i - First]);
+			}
+
+			FSimulatedPacket Packet;
+			Packet.Write(Batch);
+			if (bIsMeasuring)
+			{
+				SentBits += Packet.NumBits;
+				++NumBatches;
+			}
+
+			if (IsPacketLost())
+			{
+				NumLostBatches += bIsMeasuring ? 1 : 0;
+			}
+			else
+			{
+				Packet.DeliveryTime = Now + GetPacketDelay();
+				ToReceiver.Add(MoveTemp(Packet));
+			}
+		}
+		if (Now >= NextSendTime)
+		{
+			NextSendTime = FMath::Max(NextSendTime + Settings.SendPeriod, Now);
+		}
+
+		// receiver: read the delivered bits back, resolve them with the channel's receive streams and ack the newest ones
+		for (int32 p = ToReceiver.Num() - 1; p >= 0; --p)
+		{
+			if (ToReceiver[p].DeliveryTime > Now)
+			{
+				continue;
+			}
+
+			FMotionSnapshotBatch Batch;
+			FMotionSnapshotBatch AckBatch;
+			if (ToReceiver[p].Read(Batch))
+			{
+				for (const FMotionSnapshotBatchEntry& Entry : Batch.Entries)
+				{
+					if (Entry.NetId == 0 || Entry.NetId > Actors.Num())
+					{
+						continue;
+					}
+					FSyncedActor& Synced = Actors[Entry.NetId - 1];
+					FQuantizedMotionSnapshot Quantized;
+					bool bIsLatest = false;
+					if (!Synced.ReceiveStream.Decode(Entry, Quantized, bIsLatest))
+					{
+						continue;
+					}
+					FMotionSnapshot Snapshot = Quantized.Dequantize(Synced.Interpolator->GetSnapshotPrecision());
+					Snapshot.AuthorityEpoch = Entry.AuthorityEpoch;
+					Snapshot.ArrivalTime = Now;
+					Synced.Interpolator->ReceiveSnapshot(Snapshot);
+					if (bIsLatest)
+					{
+						FMotionSnapshotAck& Ack = AckBatch.Acks.AddDefaulted_GetRef();
+						Ack.NetId = Entry.NetId;
+						Ack.Sequence = Entry.Sequence;
+					}
+				}
+			}
+			if (AckBatch.Acks.Num() > 0 && !IsPacketLost())
+			{
+				FSimulatedPacket AckPacket;
+				AckPacket.Write(AckBatch);
+				AckPacket.DeliveryTime = Now + GetPacketDelay();
+				ToSender.Add(MoveTemp(AckPacket));
+			}
+			ToReceiver.RemoveAtSwap(p, 1, false);
+		}
+
+		for (int32 p = ToSender.Num() - 1; p >= 0; --p)
+		{
+			if (ToSender[p].DeliveryTime > Now)
+			{
+				continue;
+			}
+			FMotionSnapshotBatch AckBatch;
+			if (ToSender[p].Read(AckBatch))
+			{
+				for (const FMotionSnapshotAck& Ack : AckBatch.Acks)
+				{
+					if (Ack.NetId > 0 && Ack.NetId <= Actors.Num())
+					{
+						Actors[Ack.NetId - 1].SendStream.Ack(Ack.Sequence);
+					}
+				}
+			}
+			ToSender.RemoveAtSwap(p, 1, false);
+		}
+
+		++GFrameCounter;
+		const double TickStart = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, static_cast<float>(DeltaTime));
+		const double TickTime = (FPlatformTime::Seconds() - TickStart) * 1000.0;
+
+		if (bIsMeasuring)
+		{
+			TickTimes.Add(TickTime);
+			for (const FSyncedActor& Synced : Actors)
+			{
+				const FMotionSnapshot Truth = GetScriptedMotion(Synced.Center, Synced.Phase, Synced.Interpolator->GetLookupTime());
+				LocationErrors.Add(FVector::Dist(Truth.Location, Synced.Root->GetComponentLocation()));
+				RotationErrors.Add(FMath::RadiansToDegrees(Truth.Rotation.Quaternion().AngularDistance(Synced.Root->GetComponentQuat())));
+			}
+		}
+
+		const double Remaining = DeltaTime - (FPlatformTime::Seconds() - FrameStart);
+		if (Remaining > 0.0)
+		{
+			FPlatformProcess::Sleep(static_cast<float>(Remaining));
+		}
+	}
+
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetNumberField(TEXT("actors"), Settings.NumActors);
+	Report->SetNumberField(TEXT("duration_s"), Settings.Duration);
+	Report->SetNumberField(TEXT("tick_rate_hz"), Settings.TickRate);
+	Report->SetNumberField(TEXT("send_period_s"), Settings.SendPeriod);
+	Report->SetNumberField(TEXT("lag_ms"), Settings.Lag);
+	Report->SetNumberField(TEXT("lag_variance_ms"), Settings.LagVariance);
+	Report->SetNumberField(TEXT("loss_percent"), Settings.Loss);
+	Report->SetStringField(TEXT("precision_profile"), StaticEnum<EMotionPrecisionProfile>()->GetNameStringByValue(static_cast<int64>(Settings.PrecisionProfile)));
+	Report->SetStringField(TEXT("interpolation_mode"), StaticEnum<EMotionInterpolationMode>()->GetNameStringByValue(static_cast<int64>(Settings.InterpolationMode)));
+	Report->SetNumberField(TEXT("ticks"), TickTimes.Num());
+	Report->SetObjectField(TEXT("game_thread_ms"), MakeDistribution(TickTimes));
+	Report->SetNumberField(TEXT("bytes_per_second"), SentBits / 8.0 / Settings.Duration);
+	Report->SetNumberField(TEXT("batches"), NumBatches);
+	Report->SetNumberField(TEXT("lost_batches"), NumLostBatches);
+	Report->SetNumberField(TEXT("underruns"), NumUnderruns);
+	Report->SetNumberField(TEXT("underruns_per_actor_second"), NumUnderruns / (Settings.NumActors * static_cast<double>(Settings.Duration)));
+	Report->SetObjectField(TEXT("location_error"), MakeDistribution(LocationErrors));
+	Report->SetObjectField(TEXT("rotation_error_deg"), MakeDistribution(RotationErrors));
+
+	FString ReportString;
+	const TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&ReportString);
+	FJsonSerializer::Serialize(Report, JsonWriter);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	if (!FFileHelper::SaveStringToFile(ReportString, *Settings.OutputPath))
+	{
+		UE_LOG(LogMotionInterpolator, Error, TEXT("Failed to write the benchmark report to %s"), *Settings.OutputPath);
+		return 1;
+	}
+	UE_LOG(LogMotionInterpolator, Display, TEXT("Benchmark report written to %s"), *Settings.OutputPath);
+	UE_LOG(LogMotionInterpolator, Display, TEXT("%s"), *ReportString);
+	return 0;
+}
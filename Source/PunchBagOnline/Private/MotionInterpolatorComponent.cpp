@@ -1,11 +1,22 @@
 #include "MotionInterpolatorComponent.h"
+#include "MotionInterpolatorSubsystem.h"
+#include "MotionSyncChannelComponent.h"
+#include "MotionSnapshotCodec.h"
+#include "MotionInterpolatorStats.h"
+#include "MotionInterpolationBatch.h"
+#include "PunchBagOnline.h"
+#include "Algo/BinarySearch.h"
 #include "Kismet/KismetMathLibrary.h"
-#include "GameFramework/GameStateBase.h"
+#include "Components/ChildActorComponent.h"
+#include "Components/PoseableMeshComponent.h"
+#include "Engine/NetConnection.h"
 #include "GameFramework/PlayerState.h"
 #include "Kismet/GameplayStatics.h"
 #include "Math/UnrealMath.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
 
-FMotionSnapshot::FMotionSnapshot(const USceneComponent& InComponent, float InTimestamp) :
+FMotionSnapshot::FMotionSnapshot(const USceneComponent& InComponent, double InTimestamp) :
 	Location(InComponent.GetComponentLocation()),
 	Rotation(InComponent.GetComponentRotation()),
 	Velocity(InComponent.GetComponentVelocity()),
@@ -19,13 +30,8 @@ FMotionSnapshot::FMotionSnapshot(const USceneComponent& InComponent, float InTim
 }
 
 FMotionSnapshot::FMotionSnapshot(const USceneComponent& InComponent) :
-	FMotionSnapshot(InComponent, 0.0f)
+	FMotionSnapshot(InComponent, UMotionInterpolatorSubsystem::GetWorldSyncedTime(InComponent.GetWorld()))
 {
-	const UWorld* World = InComponent.GetWorld();
-	if (IsValid(World))
-	{
-		Timestamp = World->GetGameState()->GetServerWorldTimeSeconds();
-	}
 }
 
 void FMotionSnapshot::ApplyTo(USceneComponent& InComponent)
@@ -39,6 +45,14 @@ void FMotionSnapshot::ApplyTo(USceneComponent& InComponent)
 	}
 }
 
+FMotionSnapshotTransform FMotionSnapshotTransform::Lerp(const FMotionSnapshotTransform& A, const FMotionSnapshotTransform& B, float Alpha)
+{
+	FMotionSnapshotTransform Result;
+	Result.Location = FMath::Lerp(A.Location, B.Location, Alpha);
+	Result.Rotation = FQuat::Slerp(A.Rotation, B.Rotation, Alpha);
+	return Result;
+}
+
 bool FMotionSnapshot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
 {
 	// pack bitfield with flags
@@ -51,6 +65,18 @@ bool FMotionSnapshot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuc
 	{
 		flags |= EMotionSnapshotFlags::HasAngularVelocity;
 	}
+	if (Transforms.Num() > 0)
+	{
+		flags |= EMotionSnapshotFlags::HasTransforms;
+	}
+	if (AuthorityEpoch != 0)
+	{
+		flags |= EMotionSnapshotFlags::HasAuthorityEpoch;
+	}
+	if (Samples.Num() > 0)
+	{
+		flags |= EMotionSnapshotFlags::HasSamples;
+	}
 	uint8 bits = static_cast<uint8>(flags);
 	Ar.SerializeBits(&(bits), static_cast<uint8>(EMotionSnapshotFlags::FLAGS_COUNT));
 	flags = static_cast<EMotionSnapshotFlags>(bits);
@@ -60,7 +86,12 @@ bool FMotionSnapshot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuc
 	// update location, rotation, linear velocity
 	bOutSuccess &= SerializePackedVector<10, 27>(Location, Ar);
 
-	Rotation.SerializeCompressedShort(Ar);
+	FQuat Quat = Ar.IsSaving() ? Rotation.Quaternion() : FQuat::Identity;
+	FSmallestThreeQuat::Serialize(Ar, Quat, FMotionSnapshotPrecision().RotationBits);
+	if (Ar.IsLoading())
+	{
+		Rotation = Quat.Rotator();
+	}
 
 	if (EnumHasAnyFlags(flags, EMotionSnapshotFlags::HasVelocity))
 	{
@@ -73,14 +104,88 @@ bool FMotionSnapshot::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuc
 
 	Ar << Timestamp;
 
-	if (Ar.IsLoading())
+	if (EnumHasAnyFlags(flags, EMotionSnapshotFlags::HasTransforms))
+	{
+		uint32 NumTransforms = static_cast<uint32>(Transforms.Num());
+		Ar.SerializeIntPacked(NumTransforms);
+		if (NumTransforms > MaxMotionSyncTargets)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+		if (Ar.IsLoading())
+		{
+			Transforms.SetNum(NumTransforms);
+		}
+		for (FMotionSnapshotTransform& Transform : Transforms)
+		{
+			bOutSuccess &= SerializePackedVector<100, 24>(Transform.Location, Ar);
+			FSmallestThreeQuat::Serialize(Ar, Transform.Rotation, FMotionTransformPrecision().RotationBits);
+		}
+	}
+	else if (Ar.IsLoading())
+	{
+		Transforms.Reset();
+	}
+
+	if (EnumHasAnyFlags(flags, EMotionSnapshotFlags::HasAuthorityEpoch))
+	{
+		Ar << AuthorityEpoch;
+	}
+	else if (Ar.IsLoading())
+	{
+		AuthorityEpoch = 0;
+	}
+
+	if (EnumHasAnyFlags(flags, EMotionSnapshotFlags::HasSamples))
 	{
-		const UWorld* World = Map->GetWorld();
-		if (IsValid(World) && IsValid(World->GetGameState()))
+		uint32 NumSamples = static_cast<uint32>(Samples.Num());
+		Ar.SerializeIntPacked(NumSamples);
+		if (NumSamples > MaxMotionSnapshotSamples)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+		if (Ar.IsLoading())
+		{
+			Samples.SetNum(NumSamples);
+		}
+		for (FMotionSnapshotSample& Sample : Samples)
 		{
-			ArrivalTime = World->GetGameState()->GetServerWorldTimeSeconds();
+			// samples are close to the snapshot in space and time
+			FVector Offset = Ar.IsSaving() ? Sample.Location - Location : FVector::ZeroVector;
+			bOutSuccess &= SerializePackedVector<100, 20>(Offset, Ar);
+			FQuat SampleQuat = Ar.IsSaving() ? Sample.Rotation.Quaternion() : FQuat::Identity;
+			FSmallestThreeQuat::Serialize(Ar, SampleQuat, FMotionSnapshotPrecision().RotationBits);
+			uint32 AgeMilliseconds = Ar.IsSaving() ? static_cast<uint32>(FMath::Max(FMath::RoundToInt(static_cast<float>(Timestamp - Sample.Timestamp) * 1000.0f), 0)) : 0;
+			Ar.SerializeIntPacked(AgeMilliseconds);
+			if (Ar.IsLoading())
+			{
+				Sample.Location = Location + Offset;
+				Sample.Rotation = SampleQuat.Rotator();
+				Sample.Timestamp = Timestamp - AgeMilliseconds / 1000.0;
+			}
+
+			// one per sync target of the snapshot, missing ones are sent as identity
+			Sample.Transforms.SetNum(Transforms.Num());
+			for (FMotionSnapshotTransform& Transform : Sample.Transforms)
+			{
+				bOutSuccess &= SerializePackedVector<100, 24>(Transform.Location, Ar);
+				FSmallestThreeQuat::Serialize(Ar, Transform.Rotation, FMotionTransformPrecision().RotationBits);
+			}
 		}
 	}
+	else if (Ar.IsLoading())
+	{
+		Samples.Reset();
+	}
+
+	if (Ar.IsLoading())
+	{
+		ArrivalTime = UMotionInterpolatorSubsystem::GetPacketArrivalTime(Map);
+	}
 
 	return true;
 }
@@ -93,18 +198,120 @@ UMotionInterpolatorComponent::UMotionInterpolatorComponent()
 	SetIsReplicatedByDefault(true);
 }
 
+void UMotionInterpolatorComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (IsValid(Subsystem))
+	{
+		if (TickMode == EMotionInterpolatorTickMode::Batched)
+		{
+			Subsystem->RegisterInterpolator(this);
+			SetComponentTickEnabled(false);
+			bIsBatchTicked = true;
+		}
+		else
+		{
+			Subsystem->RegisterComponentTick(this);
+		}
+		if (GetOwnerRole() == ROLE_Authority)
+		{
+			SyncNetId = Subsystem->RegisterNetId(this);
+		}
+		else if (SyncNetId != 0)
+		{
+			Subsystem->RegisterNetId(this, SyncNetId);
+		}
+	}
+}
+
+void UMotionInterpolatorComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WakeTick();
+
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (IsValid(Subsystem))
+	{
+		if (bIsBatchTicked)
+		{
+			Subsystem->UnregisterInterpolator(this);
+		}
+		else
+		{
+			Subsystem->UnregisterComponentTick(this);
+		}
+		if (SyncNetId != 0 && Subsystem->FindInterpolatorByNetId(SyncNetId) == this)
+		{
+			Subsystem->UnregisterNetId(SyncNetId);
+		}
+		Subsystem->RemoveRewindHistory(this);
+		// decode tasks hold on to this component until they are done
+		Subsystem->WaitForSnapshotDecodes();
+	}
+	ReceivedSnapshots.Empty();
+	bHasReceivedSnapshots = false;
+	bIsBatchTicked = false;
+	PendingImpacts.Reset();
+	DEC_MEMORY_STAT_BY(STAT_MotionInterp_SnapshotBufferMemory, Snapshots.GetAllocatedSize());
+	Snapshots = FMotionSnapshotBuffer();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UMotionInterpolatorComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(UMotionInterpolatorComponent, SyncNetId, COND_InitialOnly);
+	DOREPLIFETIME(UMotionInterpolatorComponent, PrecisionProfile);
+	DOREPLIFETIME(UMotionInterpolatorComponent, CustomPrecision);
+}
+
+void UMotionInterpolatorComponent::OnRep_SyncNetId()
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (IsValid(Subsystem) && SyncNetId != 0)
+	{
+		Subsystem->RegisterNetId(this, SyncNetId);
+	}
+}
+
 void UMotionInterpolatorComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	
-	const float currentSyncedTime = GetGameState()->GetServerWorldTimeSeconds();
 
-	USceneComponent* component = GetComponentToSync();
+	MOTIONINTERP_SCOPE(ComponentTick);
+
+	// the batch tick may run after this one
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (IsValid(Subsystem))
+	{
+		Subsystem->DrainReceivedSnapshots();
+	}
+
+	FMotionInterpolatorTickContext Context;
+	PrepareMotionTick(DeltaTime, GetSyncedTime(), Context);
+	if (Context.bNeedsLookup)
+	{
+		ResolveMotionTick(Context);
+		MOTIONINTERP_COUNT(Extrapolations, Context.bIsExtrapolated ? 1 : 0);
+	}
+	// queued physics targets are written by the batch tick, once per frame for every interpolator
+	FinishMotionTick(DeltaTime, Context);
+}
+
+void UMotionInterpolatorComponent::PrepareMotionTick(float DeltaTime, double CurrentSyncedTime, FMotionInterpolatorTickContext& Context)
+{
+	Context.SyncedTime = CurrentSyncedTime;
+	Context.Component = GetComponentToSync();
+
+	USceneComponent* component = Context.Component;
 
 	if (IsValid(component))
 	{
 		bool hasMovementAuthority = false;
-		if (currentSyncedTime <= AuthorityReleaseTime)
+		if (CurrentSyncedTime <= AuthorityReleaseTime)
 		{
 			hasMovementAuthority = true;
 		}
@@ -113,60 +320,160 @@ void UMotionInterpolatorComponent::TickComponent(float DeltaTime, ELevelTick Tic
 			const AActor* Owner = GetOwner();
 			if (IsValid(Owner))
 			{
-				hasMovementAuthority = GetOwnerRole() == ROLE_Authority ? !Owner->HasNetOwner() || Owner->HasLocalNetOwner() : Owner->HasLocalNetOwner();
+				if (GetOwnerRole() == ROLE_Authority)
+				{
+					if (bIsClaimedByClient && (CurrentSyncedTime > AuthorityClaimExpireTime || !AuthorityClaimConnection.IsValid()))
+					{
+						RevokeAuthorityClaim();
+					}
+					hasMovementAuthority = !bIsClaimedByClient && (!Owner->HasNetOwner() || Owner->HasLocalNetOwner());
+				}
+				else
+				{
+					hasMovementAuthority = bHasClaimedAuthority || Owner->HasLocalNetOwner();
+				}
 			}
 		}
 
+		if (bDriveNetDormancy && GetOwnerRole() == ROLE_Authority)
+		{
+			UpdateNetDormancy(DeltaTime, *component);
+		}
+
 		if (HadMovementAuthority != hasMovementAuthority)
 		{
 			if (!HadMovementAuthority)
 			{
 				Snapshots.Empty();
+				bHasSentSnapshot = false;
 			}
 			else
 			{
 				CurrentAuthorityBlendTime = AuthorityBlendTime;
 			}
+			PendingSamples.Reset();
+			bIsSampleClockRunning = false;
+			// the new authority already simulated them
+			PendingImpacts.Reset();
 			HadMovementAuthority = hasMovementAuthority;
 		}
 
 		if (hasMovementAuthority)
 		{
 			float syncPeriod = SyncPeriod;
+			bool isHighFreq = false;
 			if (CurrentHightFreqSyncDuration > KINDA_SMALL_NUMBER || CurrentHightFreqSyncDuration == -1.0f)
 			{
 				CurrentHightFreqSyncDuration = FMath::Max(CurrentHightFreqSyncDuration-DeltaTime, 0.0f);
 				syncPeriod = HighFreqSyncPeriod;
+				isHighFreq = true;
+			}
+			// scheduled sends queue every frame and the channels turn the unsent poses into samples, see UMotionSyncChannelComponent::QueueSnapshot
+			const bool bIsSendScheduled = IsSendScheduled();
+			if (IsSampling() && !bIsSendScheduled)
+			{
+				RecordSamples(*component, CurrentSyncedTime);
+			}
+			if (bIsSendScheduled || syncPeriod < KINDA_SMALL_NUMBER || (CurrentSyncedTime - LastSyncTime) > syncPeriod)
+			{
+				FMotionSnapshot Snapshot(*component, CurrentSyncedTime);
+				CaptureSyncTargets(*component, Snapshot.Transforms);
+				Snapshot.AuthorityEpoch = AuthorityEpoch;
+				// high frequency updates are there for ownership handoffs, they always send
+				if (!bUseDeadReckoning || isHighFreq || HasDeadReckoningError(Snapshot))
+				{
+					TakePendingSamples(Snapshot);
+					SendSnapshot(Snapshot);
+					LastSyncTime = CurrentSyncedTime;
+					LastSentSnapshot = Snapshot;
+					bHasSentSnapshot = true;
+				}
 			}
-			if ((syncPeriod < KINDA_SMALL_NUMBER || (currentSyncedTime - LastSyncTime) > syncPeriod))
+
+			if (GetOwnerRole() == ROLE_Authority)
 			{
-				ServerSendSnapshot(FMotionSnapshot(*component, currentSyncedTime), GUID);
-				LastSyncTime = currentSyncedTime;
+				FMotionSnapshot Pose(*component, CurrentSyncedTime);
+				CaptureSyncTargets(*component, Pose.Transforms);
+				RecordRewindPose(Pose, *component);
 			}
 		}
-		else if (SnapPeriod < KINDA_SMALL_NUMBER || (currentSyncedTime - LastSnapTime) > SnapPeriod)
+		else if (SnapPeriod < KINDA_SMALL_NUMBER || (CurrentSyncedTime - LastSnapTime) > SnapPeriod)
 		{
-			FMotionSnapshot Snapshot;
-			int OffBorder = 0;
-			GetSnapshotAtTime(GetLookupTime(), UseExtrapolation, Snapshot, OffBorder);
+			Context.bNeedsLookup = true;
+			Context.LookupTime = CurrentSyncedTime - GetLookupTimeOffset();
+		}
+	}
+}
+
+void UMotionInterpolatorComponent::ResolveMotionTick(FMotionInterpolatorTickContext& Context, FMotionInterpolationBatch* Batch, int32 BatchIndex)
+{
+	// the kernel only knows the synced component's state
+	if (Batch != nullptr && SyncTargets.Num() == 0)
+	{
+		const int32 SecondIndex = FindInterpolationSegment(Context.LookupTime);
+		if (SecondIndex != INDEX_NONE)
+		{
+			Batch->SetSegment(BatchIndex, Snapshots.GetEntry(SecondIndex - 1), Snapshots.GetEntry(SecondIndex), Context.LookupTime, InterpolationMode);
+			Context.OffBorder = 0;
+			Context.bIsBatchInterpolated = true;
+			return;
+		}
+	}
+	GetSnapshotAtTime(Context.LookupTime, UseExtrapolation, Context.Snapshot, Context.OffBorder, &Context.bIsExtrapolated);
+}
+
+void UMotionInterpolatorComponent::FinishMotionTick(float DeltaTime, FMotionInterpolatorTickContext& Context)
+{
+	USceneComponent* component = Context.Component;
+
+	if (!HadMovementAuthority && PendingImpacts.Num() > 0)
+	{
+		ApplyDueImpacts(Context.SyncedTime - GetLookupTimeOffset());
+	}
 
-			if (OffBorder == 0)
+	if (Context.bNeedsLookup && IsValid(component))
+	{
+		FMotionSnapshot& Snapshot = Context.Snapshot;
+		const bool isCorrectingImpact = IsCorrectingImpact(Context.SyncedTime);
+		// dead reckoning senders go quiet while receivers can predict them, holding the newest snapshot is expected then
+		const bool isHeldByDeadReckoning = bUseDeadReckoning && Context.OffBorder > 0 && Context.LookupTime - Snapshot.Timestamp <= DeadReckoningKeepalivePeriod;
+		// so do senders sleeping at rest, they only send keepalives
+		const bool isHeldAtRest = Context.OffBorder > 0 && IsSnapshotAtRest(Snapshot);
+		if (isCorrectingImpact && Snapshot.Timestamp < LastImpactTime)
+		{
+			// the snapshot predates the impact, the local simulation is ahead of it
+		}
+		else if (Context.OffBorder == 0 || isHeldByDeadReckoning || isHeldAtRest)
+		{
+			if (CurrentAuthorityBlendTime > KINDA_SMALL_NUMBER)
 			{
-				if (CurrentAuthorityBlendTime > KINDA_SMALL_NUMBER)
-				{
-					CurrentAuthorityBlendTime -= DeltaTime;
-					const float Alpha = 1 - (CurrentAuthorityBlendTime / AuthorityBlendTime);
-					Snapshot = SimpleInterpolate(FMotionSnapshot(*component), Snapshot, Alpha);
-					Snapshot.Velocity = FVector::ZeroVector;
-					Snapshot.AngularVelocity = FVector::ZeroVector;
-				}
-				Snapshot.ApplyTo(*component);
-				LastSnapTime = currentSyncedTime;
+				CurrentAuthorityBlendTime -= DeltaTime;
+				const float Alpha = 1 - (CurrentAuthorityBlendTime / AuthorityBlendTime);
+				FMotionSnapshot Current(*component);
+				CaptureSyncTargets(*component, Current.Transforms);
+				Snapshot = SimpleInterpolate(Current, Snapshot, Alpha);
+				Snapshot.Velocity = FVector::ZeroVector;
+				Snapshot.AngularVelocity = FVector::ZeroVector;
 			}
-			else
+			else if (isCorrectingImpact && ImpactCorrectionTime > KINDA_SMALL_NUMBER)
 			{
-				OnNotEnoughData.Broadcast();
+				FMotionSnapshot Current(*component);
+				if (FVector::DistSquared(Current.Location, Snapshot.Location) <= FMath::Square(ImpactSnapDistance))
+				{
+					// velocities are blended as well, so the body keeps simulating toward the authority
+					CaptureSyncTargets(*component, Current.Transforms);
+					const float Alpha = 1.0f - FMath::Exp(-static_cast<float>(Context.SyncedTime - LastSnapTime) / ImpactCorrectionTime);
+					Snapshot = SimpleInterpolate(Current, Snapshot, Alpha);
+				}
 			}
+			ApplySnapshot(Snapshot, *component);
+			ApplySyncTargets(Snapshot, *component);
+			LastSnapTime = Context.SyncedTime;
+		}
+		else
+		{
+			MOTIONINTERP_COUNT(Underruns, 1);
+			OnNotEnoughData.Broadcast();
 		}
 	}
 
@@ -180,6 +487,8 @@ void UMotionInterpolatorComponent::TickComponent(float DeltaTime, ELevelTick Tic
 		CurrentOwnershipDuration -= DeltaTime;
 		if (CurrentOwnershipDuration < KINDA_SMALL_NUMBER)
 		{
+			OwnershipReleaseStartTime = Context.SyncedTime;
+			TRACE_BOOKMARK(TEXT("MotionInterp release ownership %s"), *GetName());
 			ClientReleaseOwnership();
 		}
 	}
@@ -193,172 +502,1002 @@ void UMotionInterpolatorComponent::TickComponent(float DeltaTime, ELevelTick Tic
 			OnAdditionalDelayReached.Unbind();
 		}
 	}
+
+	UpdateTickSleep(DeltaTime, Context);
+}
+
+void UMotionInterpolatorComponent::ApplySnapshot(FMotionSnapshot& Snapshot, USceneComponent& Component)
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(&Component);
+	// welded bodies and multi body components like skeletal meshes have no body of their own to target
+	FBodyInstance* BodyInstance = IsValid(Primitive) ? &Primitive->BodyInstance : nullptr;
+	if (ApplyMode == EMotionApplyMode::Teleport || !IsValid(Subsystem) || BodyInstance == nullptr || !BodyInstance->IsValidBodyInstance() || BodyInstance->WeldParent != nullptr)
+	{
+		Snapshot.ApplyTo(Component);
+		return;
+	}
+
+	// rendering, attachments and gameplay see the new transform right away, the body follows with the batch
+	Component.SetWorldLocationAndRotationNoPhysics(Snapshot.Location, Snapshot.Rotation);
+	Subsystem->QueuePhysicsTarget(*BodyInstance, Component.GetComponentTransform(), Snapshot.Velocity, Snapshot.AngularVelocity);
 }
 
 void UMotionInterpolatorComponent::SetComponentOverride(class USceneComponent* InComponentOverride)
 {
 	ComponentOverride = InComponentOverride;
+	WakeTick();
 }
 
 void UMotionInterpolatorComponent::AddSnapshot(const FMotionSnapshot& Snapshot)
 {
-	if (Snapshots.Num() >= BufferSize)
+	if (FMotionSnapshotRecorder* Recorder = GetRecorder())
+	{
+		Recorder->Record(GetRecordingStreamId(), EMotionSnapshotRecordKind::Received, Snapshot);
+	}
+
+	const SIZE_T OldSize = Snapshots.GetAllocatedSize();
+	Snapshots.SetCapacity(GetBufferCapacity());
+	const bool bAdded = Snapshots.Add(Snapshot);
+	const SIZE_T NewSize = Snapshots.GetAllocatedSize();
+	if (NewSize != OldSize)
+	{
+		DEC_MEMORY_STAT_BY(STAT_MotionInterp_SnapshotBufferMemory, OldSize);
+		INC_MEMORY_STAT_BY(STAT_MotionInterp_SnapshotBufferMemory, NewSize);
+	}
+
+	if (bAdded)
 	{
-		Snapshots.RemoveAt(0, (Snapshots.Num() - BufferSize) + 1);
+		OnSnapshotAdded.Broadcast(Snapshot);
 	}
-	Snapshots.Add(Snapshot);
-	OnSnapshotAdded.Broadcast(Snapshot);
 }
 
-void UMotionInterpolatorComponent::GetSnapshotAtTime(float TargetTime, bool CanExtrapolate, FMotionSnapshot& Result, int& OffBorder)
+void UMotionInterpolatorComponent::GetSnapshotAtTime(double TargetTime, bool CanExtrapolate, FMotionSnapshot& Result, int& OffBorder, bool* bOutIsExtrapolated)
 {
 	OffBorder = 0;
-	if (Snapshots.Num() <= 0)
+	if (bOutIsExtrapolated != nullptr)
+	{
+		*bOutIsExtrapolated = false;
+	}
+	if (Snapshots.IsEmpty())
 	{
 		OffBorder = -1;
 		return;
 	}
-	else if (TargetTime <= Snapshots[0].Timestamp)
+	else if (TargetTime <= Snapshots.GetFirstTimestamp())
 	{
 		OffBorder = -1;
-		Result = Snapshots[0];
+		Snapshots.GetSnapshot(0, Result);
 		return;
 	}
-	else if (TargetTime >= Snapshots.Last().Timestamp)
+	else if (TargetTime >= Snapshots.GetLastTimestamp())
 	{
 		if (!CanExtrapolate)
 		{
 			OffBorder = 1;
-			Result = Snapshots.Last();
-			return;
-		}
-	}
-
-	FMotionSnapshot FirstSnapshot;
-	FMotionSnapshot SecondSnapshot;
-	for (size_t i = 0; i < Snapshots.Num(); i++)
-	{
-		if (Snapshots[i].Timestamp == TargetTime)
-		{
-			Result = Snapshots[i];
-			return;
-		}
-		else if (i + 1 < Snapshots.Num() && Snapshots[i + 1].Timestamp > TargetTime)
-		{
-			FirstSnapshot = Snapshots[i];
-			SecondSnapshot = Snapshots[i + 1];
-			Result = Interpolate(FirstSnapshot, SecondSnapshot, TargetTime);
+			Snapshots.GetSnapshot(Snapshots.Num() - 1, Result);
 			return;
 		}
-		else if (i + 1 == Snapshots.Num())
+		if (bOutIsExtrapolated != nullptr)
 		{
-			FirstSnapshot = Snapshots[i];
-			Result = Extrapolate(FirstSnapshot, TargetTime);
-			return;
+			*bOutIsExtrapolated = true;
 		}
+		Result = Extrapolate(Snapshots.GetLast(), TargetTime);
+		return;
 	}
-}
 
-void UMotionInterpolatorComponent::ServerSendSnapshot_Implementation(const FMotionSnapshot& InSnapshot, FGuid SenderGuid)
-{
-	MulticastSendSnapshot(InSnapshot, SenderGuid);
+	// TargetTime is strictly inside the buffer, so both neighbours exist
+	const int32 SecondIndex = Snapshots.UpperBound(TargetTime);
+	if (Snapshots.GetTimestamp(SecondIndex - 1) == TargetTime)
+	{
+		Snapshots.GetSnapshot(SecondIndex - 1, Result);
+		return;
+	}
+	Result = Interpolate(Snapshots.GetSnapshot(SecondIndex - 1), Snapshots.GetSnapshot(SecondIndex), TargetTime);
 }
 
-void UMotionInterpolatorComponent::MulticastSendSnapshot_Implementation(const FMotionSnapshot& InSnapshot, FGuid SenderGuid)
+int32 UMotionInterpolatorComponent::FindInterpolationSegment(double TargetTime) const
 {
-	if (SenderGuid != GUID)
+	if (Snapshots.Num() < 2 || TargetTime <= Snapshots.GetFirstTimestamp() || TargetTime >= Snapshots.GetLastTimestamp())
 	{
-		AddSnapshot(InSnapshot);
-		if (!bUseFixedNetworkDelay)
-		{
-			float TimeSinceLastSnapshot = 0.0f;
-			const AGameStateBase* gameState = GetGameState();
-			if (IsValid(gameState) && Snapshots.Num() > 1)
-			{
-				TimeSinceLastSnapshot = gameState->GetServerWorldTimeSeconds() - Snapshots[Snapshots.Num()-2].ArrivalTime;
-			}
-			const float maxDelay = GetSnapshotsMaxDelay();
-			TargetNetworkDelay = (maxDelay+TimeSinceLastSnapshot)*1.5;
-		}
+		return INDEX_NONE;
 	}
+	const int32 SecondIndex = Snapshots.UpperBound(TargetTime);
+	return Snapshots.GetTimestamp(SecondIndex - 1) == TargetTime ? INDEX_NONE : SecondIndex;
 }
 
-void UMotionInterpolatorComponent::ClientSendSnapshot_Implementation(const FMotionSnapshot& InSnapshot)
+TArray<FMotionSnapshot> UMotionInterpolatorComponent::GetSnapshots()
 {
-	AddSnapshot(InSnapshot);
+	TArray<FMotionSnapshot> Result;
+	Result.SetNum(Snapshots.Num());
+	for (int32 i = 0; i < Snapshots.Num(); ++i)
+	{
+		Snapshots.GetSnapshot(i, Result[i]);
+	}
+	return Result;
 }
 
-void UMotionInterpolatorComponent::ServerTakeOwnership_Implementation(AActor* newOwner, float OwnershipDuration)
+bool UMotionInterpolatorComponent::GetSnapshot(int32 Index, FMotionSnapshot& OutSnapshot) const
 {
-	ensureMsgf(GetOwnerRole() == ENetRole::ROLE_Authority, TEXT("'%s' calls ServerTakeOwnership on client! This will have no effect."), *GetName());
-	AActor* componentOwner = GetOwner();
-	if (IsValid(componentOwner) && (!componentOwner->HasNetOwner() || newOwner != componentOwner->GetOwner()))
+	if (Index < 0 || Index >= Snapshots.Num())
 	{
-		componentOwner->SetOwner(newOwner);
-		CurrentOwnershipDuration = OwnershipDuration;
+		return false;
 	}
+	Snapshots.GetSnapshot(Index, OutSnapshot);
+	return true;
 }
 
-void UMotionInterpolatorComponent::ServerReleaseOwnership_Implementation(const FMotionSnapshot& InSnapshot, float ClientNetworkDelay)
+void UMotionInterpolatorComponent::ServerSendSnapshot_Implementation(const FMotionSnapshot& InSnapshot, FGuid SenderGuid)
 {
-	TargetAdditionalNetworkDelay = -(NetworkDelay + ClientNetworkDelay);
-	OnAdditionalDelayReached.ExecuteIfBound();
-	OnAdditionalDelayReached.Unbind();
-
-	OnAdditionalDelayReached.BindLambda([this]() {
-		AActor* componentOwner = GetOwner();
-		if (IsValid(componentOwner))
+	// route through the interest managed channels when possible instead of multicasting to everyone, sender included
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (bUseSnapshotBatching && SyncNetId != 0 && IsValid(Subsystem))
+	{
+		const AActor* Owner = GetOwner();
+		UMotionSyncChannelComponent* SourceChannel = Subsystem->FindChannelByConnection(IsValid(Owner) ? Owner->GetNetConnection() : nullptr);
+		if (SenderGuid != GUID)
 		{
-			componentOwner->SetOwner(nullptr);
+			ReceiveSnapshot(InSnapshot, SourceChannel);
 		}
-		TargetAdditionalNetworkDelay = 0.0f;
-		EnableTempHighFreqUpdate();
-	});
+		Subsystem->ForwardSnapshot(SyncNetId, InSnapshot, SourceChannel, SenderGuid);
+		return;
+	}
+	MulticastSendSnapshot(InSnapshot, SenderGuid);
 }
 
-void UMotionInterpolatorComponent::EnableTempHighFreqUpdate()
+void UMotionInterpolatorComponent::MulticastSendSnapshot_Implementation(const FMotionSnapshot& InSnapshot, FGuid SenderGuid)
 {
-	CurrentHightFreqSyncDuration = HighFreqSyncDuration;
+	// multicasts run on the server too, which already received or sent the snapshot
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return;
+	}
+	if (SenderGuid != GUID && !IsReceivingThroughChannel())
+	{
+		UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+		ReceiveSnapshot(InSnapshot, IsValid(Subsystem) ? Subsystem->GetLocalChannel() : nullptr);
+	}
 }
 
-void UMotionInterpolatorComponent::SetHighFreqUpdateEnabled(bool Enabled)
+bool UMotionInterpolatorComponent::IsReceivingThroughChannel() const
 {
-	CurrentHightFreqSyncDuration = Enabled ? -1.0f : 0.0f;
+	// the server forwards to channels and only multicasts for the connections without one
+	if (!bUseSnapshotBatching || SyncNetId == 0 || GetOwnerRole() == ROLE_Authority)
+	{
+		return false;
+	}
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	return IsValid(Subsystem) && IsValid(Subsystem->GetLocalChannel());
 }
 
-void UMotionInterpolatorComponent::ClientReleaseOwnership_Implementation()
+void UMotionInterpolatorComponent::SendImpact(FVector Location, FVector Impulse, AActor* Hitter)
 {
-	const FMotionSnapshot& latestSnapshot = FMotionSnapshot(*GetComponentToSync());
-	ServerReleaseOwnership(latestSnapshot, NetworkDelay);
-	EnableTempHighFreqUpdate();
-	//TargetAdditionalNetworkDelay = NetworkDelay;
-}
+	FMotionImpactEvent Impact;
+	Impact.Location = Location;
+	Impact.Impulse = Impulse;
+	Impact.Hitter = Hitter;
+	Impact.Timestamp = GetSyncedTime();
+	ApplyImpact(Impact);
 
-float UMotionInterpolatorComponent::GetLookupTime()
-{
-	const AGameStateBase* gameState = GetGameState();
-	if (IsValid(gameState))
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		if (SyncNetId != 0 && IsValid(Subsystem))
+		{
+			WakeNetDormancy();
+			Subsystem->ForwardImpact(SyncNetId, Impact, nullptr, GUID);
+			return;
+		}
+		MOTIONINTERP_COUNT(ImpactsSent, 1);
+		WakeNetDormancy();
+		MulticastSendImpact(Impact, GUID);
+		return;
+	}
+
+	// server RPCs on the hit body would be dropped, the client doesn't own it
+	UMotionSyncChannelComponent* Channel = IsValid(Subsystem) ? Subsystem->GetLocalChannel() : nullptr;
+	if (!ensureMsgf(SyncNetId != 0 && IsValid(Channel), TEXT("%s can't send an impact without a net id and a motion sync channel, the game mode has to add channels"), *GetName()))
 	{
-		return gameState->GetServerWorldTimeSeconds() - GetLookupTimeOffset();
+		UE_LOG(LogMotionInterpolator, Warning, TEXT("%s dropped an impact, it is only applied locally"), *GetName());
+		return;
 	}
-	return 0.0f;
+	MOTIONINTERP_COUNT(ImpactsSent, 1);
+	Channel->ServerReceiveImpact(SyncNetId, Impact);
 }
 
-void UMotionInterpolatorComponent::OvertakeMovementAuthority(float Duration)
+void UMotionInterpolatorComponent::MulticastSendImpact_Implementation(const FMotionImpactEvent& Impact, FGuid SenderGuid)
 {
-	AuthorityReleaseTime = GetWorld()->GetGameState()->GetServerWorldTimeSeconds() + Duration;
+	// multicasts run on the server too, which already applied the impact
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		return;
+	}
+	// clients with a channel get impacts through it, whatever the snapshots use
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	const bool bHasChannel = SyncNetId != 0 && IsValid(Subsystem) && IsValid(Subsystem->GetLocalChannel());
+	if (SenderGuid != GUID && !bHasChannel)
+	{
+		ReceiveImpact(Impact, nullptr);
+	}
 }
 
-FMotionSnapshot UMotionInterpolatorComponent::Interpolate(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, float TargetTime)
+void UMotionInterpolatorComponent::ReceiveImpact(const FMotionImpactEvent& Impact, UMotionSyncChannelComponent* SourceChannel, const FGuid& SenderGuid)
 {
-	FMotionSnapshot Result;
+	MOTIONINTERP_COUNT(ImpactsReceived, 1);
+	WakeTick();
 
-	float Alpha = UKismetMathLibrary::NormalizeToRange(TargetTime, FirstSnapshot.Timestamp, SecondSnapshot.Timestamp);
+	FMotionImpactEvent Received = Impact;
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		if (!IsImpactPlausible(Received, SourceChannel))
+		{
+			MOTIONINTERP_COUNT(ImpactsRejected, 1);
+			return;
+		}
+		if (MaxImpactImpulse > 0.0f)
+		{
+			Received.Impulse = Received.Impulse.GetClampedToMaxSize(MaxImpactImpulse);
+		}
+		WakeNetDormancy();
+		UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+		if (SyncNetId != 0 && IsValid(Subsystem))
+		{
+			Subsystem->ForwardImpact(SyncNetId, Received, SourceChannel, SenderGuid);
+		}
+		else
+		{
+			MulticastSendImpact(Received, SenderGuid);
+		}
+	}
 
-	float PredictionTime = TargetTime - FirstSnapshot.Timestamp;
-	float ReversePredictionTime = SecondSnapshot.Timestamp - TargetTime;
+	if (HadMovementAuthority)
+	{
+		ApplyImpact(Received);
+		return;
+	}
 
-	// Location of the object predicted from what we knew before
+	// proxies play it out where the sender's snapshots will show it
+	const int32 Index = Algo::UpperBoundBy(PendingImpacts, Received.Timestamp, &FMotionImpactEvent::Timestamp);
+	PendingImpacts.Insert(Received, Index);
+}
+
+bool UMotionInterpolatorComponent::IsImpactPlausible(const FMotionImpactEvent& Impact, const UMotionSyncChannelComponent* SourceChannel) const
+{
+	const FVector Location = Impact.Location;
+	const USceneComponent* Component = GetSyncedComponent();
+	const float BoundsDistance = IsValid(Component) ? FMath::Sqrt(Component->Bounds.GetBox().ComputeSquaredDistanceToPoint(Location)) : 0.0f;
+	if (BoundsDistance > MaxImpactLocationError)
+	{
+		UE_LOG(LogMotionInterpolator, Log, TEXT("%s dropped an impact %.0f away from its bounds"), *GetName(), BoundsDistance);
+		return false;
+	}
+
+	// a player without interest points yet can't be checked, the hitter still can
+	const float InstigatorDistance = IsValid(SourceChannel) ? SourceChannel->GetInterestDistance(Location) : MAX_flt;
+	if (InstigatorDistance != MAX_flt && InstigatorDistance > MaxImpactInstigatorDistance)
+	{
+		UE_LOG(LogMotionInterpolator, Log, TEXT("%s dropped an impact %.0f away from %s"), *GetName(), InstigatorDistance, *GetNameSafe(SourceChannel->GetOwner()));
+		return false;
+	}
+	if (IsValid(Impact.Hitter) && FVector::DistSquared(Impact.Hitter->GetActorLocation(), Location) > FMath::Square(MaxImpactInstigatorDistance))
+	{
+		UE_LOG(LogMotionInterpolator, Log, TEXT("%s dropped an impact out of reach of %s"), *GetName(), *Impact.Hitter->GetName());
+		return false;
+	}
+	return true;
+}
+
+void UMotionInterpolatorComponent::ApplyImpact(const FMotionImpactEvent& Impact)
+{
+	UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(GetComponentToSync());
+	if (IsValid(Primitive) && Primitive->IsSimulatingPhysics())
+	{
+		Primitive->AddImpulseAtLocation(Impact.Impulse, Impact.Location);
+		LastImpactTime = FMath::Max(LastImpactTime, Impact.Timestamp);
+		ImpactCorrectionEndTime = GetSyncedTime() + ImpactCorrectionDuration;
+		WakeTick();
+	}
+	OnImpactApplied.Broadcast(Impact);
+}
+
+void UMotionInterpolatorComponent::ApplyDueImpacts(double LookupTime)
+{
+	int32 NumDue = 0;
+	while (NumDue < PendingImpacts.Num() && PendingImpacts[NumDue].Timestamp <= LookupTime)
+	{
+		ApplyImpact(PendingImpacts[NumDue]);
+		++NumDue;
+	}
+	PendingImpacts.RemoveAt(0, NumDue, false);
+}
+
+bool UMotionInterpolatorComponent::IsSendScheduled() const
+{
+	if (!bUseSnapshotBatching || SyncNetId == 0)
+	{
+		return false;
+	}
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	return IsValid(Subsystem) && (GetOwnerRole() == ROLE_Authority || IsValid(Subsystem->GetLocalChannel()));
+}
+
+float UMotionInterpolatorComponent::GetSyncPeriodHint() const
+{
+	if (CurrentHightFreqSyncDuration > KINDA_SMALL_NUMBER || CurrentHightFreqSyncDuration == -1.0f)
+	{
+		return HighFreqSyncPeriod;
+	}
+	return SyncPeriod;
+}
+
+void UMotionInterpolatorComponent::SendSnapshot(const FMotionSnapshot& Snapshot)
+{
+	MOTIONINTERP_COUNT(SnapshotsSent, 1);
+	if (FMotionSnapshotRecorder* Recorder = GetRecorder())
+	{
+		Recorder->Record(GetRecordingStreamId(), EMotionSnapshotRecordKind::Sent, Snapshot);
+	}
+
+	if (bUseSnapshotBatching && SyncNetId != 0)
+	{
+		UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+		if (IsValid(Subsystem))
+		{
+			if (GetOwnerRole() == ROLE_Authority)
+			{
+				Subsystem->ForwardSnapshot(SyncNetId, Snapshot, nullptr, GUID);
+				return;
+			}
+			UMotionSyncChannelComponent* Channel = Subsystem->GetLocalChannel();
+			if (IsValid(Channel))
+			{
+				Channel->QueueSnapshot(SyncNetId, Snapshot);
+				return;
+			}
+		}
+	}
+	ServerSendSnapshot(Snapshot, GUID);
+}
+
+void UMotionInterpolatorComponent::ReceiveSnapshot(const FMotionSnapshot& Snapshot, UMotionSyncChannelComponent* SourceChannel)
+{
+	MOTIONINTERP_COUNT(SnapshotsReceived, 1);
+
+	const uint16 PreviousEpoch = AuthorityEpoch;
+	if (!UpdateAuthorityEpoch(Snapshot))
+	{
+		MOTIONINTERP_COUNT(StaleEpochSnapshots, 1);
+		return;
+	}
+
+	// keepalives of a resting sender leave sleeping proxies alone
+	if (bIsTickSleeping && (AuthorityEpoch != PreviousEpoch || Snapshots.IsEmpty() || !IsSnapshotAtRest(Snapshot) || HasMovedSince(Snapshots.GetLast(), Snapshot)))
+	{
+		WakeTick();
+	}
+
+	if (!Snapshots.IsEmpty() && Snapshot.Timestamp > Snapshots.GetLastTimestamp())
+	{
+		float Interval = static_cast<float>(Snapshot.Timestamp - Snapshots.GetLastTimestamp());
+		if (bUseDeadReckoning)
+		{
+			// gaps are intentional, they shouldn't grow the playout delay
+			Interval = FMath::Min(Interval, GetSyncPeriodHint());
+		}
+		AverageSnapshotInterval = AverageSnapshotInterval > 0.0f ? FMath::Lerp(AverageSnapshotInterval, Interval, 0.125f) : Interval;
+	}
+
+	// received snapshots are ahead of the playout delay, so hits can be validated right when they arrive
+	USceneComponent* Component = GetOwnerRole() == ROLE_Authority ? GetComponentToSync() : nullptr;
+	if (Snapshot.Samples.Num() > 0)
+	{
+		TArray<FMotionSnapshot> SampleSnapshots;
+		ExpandSamples(Snapshot, SampleSnapshots);
+		for (const FMotionSnapshot& SampleSnapshot : SampleSnapshots)
+		{
+			AddSnapshot(SampleSnapshot);
+			if (IsValid(Component))
+			{
+				RecordRewindPose(SampleSnapshot, *Component);
+			}
+		}
+	}
+
+	AddSnapshot(Snapshot);
+	if (IsValid(Component))
+	{
+		RecordRewindPose(Snapshot, *Component);
+	}
+
+	// arrival times before the first clock sync aren't on the sender's timeline, they would show up as huge transit jumps
+	const UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (!IsValid(Subsystem) || !Subsystem->IsClockSynchronized())
+	{
+		return;
+	}
+
+	// one estimator per connection and stream, each has its own send rate and transit baseline
+	const bool bHasChannelStream = IsValid(SourceChannel) && SyncNetId != 0;
+	FMotionJitterEstimator& Estimator = bHasChannelStream ? SourceChannel->GetJitterEstimator(SyncNetId) : JitterEstimator;
+	Estimator.AddSample(Snapshot.Timestamp, Snapshot.ArrivalTime);
+
+	if (!bUseFixedNetworkDelay)
+	{
+		TargetNetworkDelay = bHasChannelStream ? SourceChannel->GetPlayoutDelay(SyncNetId, AverageSnapshotInterval) : Estimator.GetPlayoutDelay(AverageSnapshotInterval, FMotionJitterEstimator::DefaultJitterMultiplier);
+	}
+}
+
+bool UMotionInterpolatorComponent::EnqueueReceivedSnapshot(FMotionReceivedSnapshot&& Received)
+{
+	ReceivedSnapshots.Enqueue(MoveTemp(Received));
+	return !bHasReceivedSnapshots.AtomicSet(true);
+}
+
+bool UMotionInterpolatorComponent::DequeueReceivedSnapshot(FMotionReceivedSnapshot& OutReceived)
+{
+	if (ReceivedSnapshots.Dequeue(OutReceived))
+	{
+		return true;
+	}
+	bHasReceivedSnapshots = false;
+	// a decode task queued one right before the flag was cleared and didn't queue this interpolator again, so keep draining it
+	if (!ReceivedSnapshots.IsEmpty() && !bHasReceivedSnapshots.AtomicSet(true))
+	{
+		return ReceivedSnapshots.Dequeue(OutReceived);
+	}
+	return false;
+}
+
+void UMotionInterpolatorComponent::ClientSendSnapshot_Implementation(const FMotionSnapshot& InSnapshot)
+{
+	WakeTick();
+	AddSnapshot(InSnapshot);
+}
+
+void UMotionInterpolatorComponent::ServerTakeOwnership_Implementation(AActor* newOwner, float OwnershipDuration)
+{
+	ensureMsgf(GetOwnerRole() == ENetRole::ROLE_Authority, TEXT("'%s' calls ServerTakeOwnership on client! This will have no effect."), *GetName());
+	AActor* componentOwner = GetOwner();
+	if (IsValid(componentOwner) && (!componentOwner->HasNetOwner() || newOwner != componentOwner->GetOwner()))
+	{
+		componentOwner->SetOwner(newOwner);
+		WakeNetDormancy();
+		WakeTick();
+		CurrentOwnershipDuration = OwnershipDuration;
+		INC_DWORD_STAT(STAT_MotionInterp_OwnershipHandoffs);
+		TRACE_BOOKMARK(TEXT("MotionInterp take ownership %s"), *GetName());
+	}
+}
+
+void UMotionInterpolatorComponent::ServerReleaseOwnership_Implementation(const FMotionSnapshot& InSnapshot, float ClientNetworkDelay)
+{
+	TargetAdditionalNetworkDelay = -(NetworkDelay + ClientNetworkDelay);
+	OnAdditionalDelayReached.ExecuteIfBound();
+	OnAdditionalDelayReached.Unbind();
+
+	OnAdditionalDelayReached.BindLambda([this]() {
+		// from asking the owner to release until the server has blended back to its own delay
+		const float ReleaseTime = static_cast<float>(GetSyncedTime() - OwnershipReleaseStartTime);
+		MOTIONINTERP_SET_FLOAT(HandoffReleaseTime, ReleaseTime);
+		TRACE_BOOKMARK(TEXT("MotionInterp ownership released %s"), *GetName());
+		UE_LOG(LogMotionInterpolator, Verbose, TEXT("%s released ownership in %.3f s"), *GetName(), ReleaseTime);
+
+		AActor* componentOwner = GetOwner();
+		if (IsValid(componentOwner))
+		{
+			componentOwner->SetOwner(nullptr);
+		}
+		WakeNetDormancy();
+		TargetAdditionalNetworkDelay = 0.0f;
+		StartTempHighFreqUpdate();
+	});
+	WakeTick();
+}
+
+void UMotionInterpolatorComponent::EnableTempHighFreqUpdate()
+{
+	if (bImpactsReplaceHighFreqUpdates)
+	{
+		return;
+	}
+	StartTempHighFreqUpdate();
+}
+
+void UMotionInterpolatorComponent::StartTempHighFreqUpdate()
+{
+	CurrentHightFreqSyncDuration = HighFreqSyncDuration;
+	WakeTick();
+}
+
+void UMotionInterpolatorComponent::SetHighFreqUpdateEnabled(bool Enabled)
+{
+	CurrentHightFreqSyncDuration = Enabled ? -1.0f : 0.0f;
+	WakeTick();
+}
+
+void UMotionInterpolatorComponent::ClientReleaseOwnership_Implementation()
+{
+	const FMotionSnapshot& latestSnapshot = FMotionSnapshot(*GetComponentToSync());
+	ServerReleaseOwnership(latestSnapshot, NetworkDelay);
+	StartTempHighFreqUpdate();
+	//TargetAdditionalNetworkDelay = NetworkDelay;
+}
+
+double UMotionInterpolatorComponent::GetLookupTime()
+{
+	return GetSyncedTime() - GetLookupTimeOffset();
+}
+
+float UMotionInterpolatorComponent::GetLookupDelay()
+{
+	return GetLookupTimeOffset();
+}
+
+void UMotionInterpolatorComponent::GetSnapshotAtAge(float Age, bool CanExtrapolate, FMotionSnapshot& Result, int& OffBorder)
+{
+	GetSnapshotAtTime(GetSyncedTime() - Age, CanExtrapolate, Result, OffBorder);
+}
+
+float UMotionInterpolatorComponent::GetSnapshotAge(const FMotionSnapshot& Snapshot) const
+{
+	return static_cast<float>(GetSyncedTime() - Snapshot.Timestamp);
+}
+
+void UMotionInterpolatorComponent::OvertakeMovementAuthority(float Duration)
+{
+	AuthorityReleaseTime = GetSyncedTime() + Duration;
+	WakeTick();
+}
+
+void UMotionInterpolatorComponent::ClaimAuthority()
+{
+	if (!bAllowAuthorityClaims)
+	{
+		return;
+	}
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		if (bIsClaimedByClient)
+		{
+			RevokeAuthorityClaim();
+		}
+		return;
+	}
+
+	// the server only sees claims in batches, and a claim has to build on the epoch it is meant to replace
+	if (!IsSendScheduled() || !bHasAuthorityEpoch)
+	{
+		UE_LOG(LogMotionInterpolator, Verbose, TEXT("%s can't claim authority before it has a snapshot channel and an epoch"), *GetName());
+		return;
+	}
+
+	++AuthorityEpoch;
+	bHasClaimedAuthority = true;
+	StartTempHighFreqUpdate();
+	TRACE_BOOKMARK(TEXT("MotionInterp claim authority %s %u"), *GetName(), AuthorityEpoch);
+}
+
+bool UMotionInterpolatorComponent::AcceptSnapshotFrom(const FMotionSnapshot& Snapshot, UNetConnection* Connection)
+{
+	const AActor* Owner = GetOwner();
+	if (!IsValid(Owner) || Connection == nullptr)
+	{
+		return false;
+	}
+
+	if (bIsClaimedByClient && AuthorityClaimConnection.Get() == Connection && Snapshot.AuthorityEpoch == AuthorityEpoch)
+	{
+		return true;
+	}
+
+	// the first claim of an epoch wins, conflicting claims arrive later with an epoch that isn't newer anymore
+	if (bAllowAuthorityClaims && IsMotionSequenceNewer(Snapshot.AuthorityEpoch, AuthorityEpoch))
+	{
+		GrantAuthorityClaim(Snapshot.AuthorityEpoch, Connection);
+		return true;
+	}
+
+	// same rule as for the Server RPCs: the owning connection can send snapshots while nobody claimed authority
+	return !bIsClaimedByClient && Owner->GetNetConnection() == Connection;
+}
+
+void UMotionInterpolatorComponent::GrantAuthorityClaim(uint16 Epoch, UNetConnection* Connection)
+{
+	AuthorityEpoch = Epoch;
+	bHasAuthorityEpoch = true;
+	bIsClaimedByClient = true;
+	AuthorityClaimConnection = Connection;
+	AuthorityClaimExpireTime = GetSyncedTime() + AuthorityClaimDuration;
+	WakeNetDormancy();
+	WakeTick();
+	INC_DWORD_STAT(STAT_MotionInterp_OwnershipHandoffs);
+	TRACE_BOOKMARK(TEXT("MotionInterp grant authority %s %u"), *GetName(), Epoch);
+}
+
+void UMotionInterpolatorComponent::RevokeAuthorityClaim()
+{
+	// the new epoch tells the claimer to stop, it gives authority back as soon as the server's snapshots arrive
+	++AuthorityEpoch;
+	bIsClaimedByClient = false;
+	AuthorityClaimConnection = nullptr;
+	StartTempHighFreqUpdate();
+	WakeNetDormancy();
+	INC_DWORD_STAT(STAT_MotionInterp_OwnershipHandoffs);
+	TRACE_BOOKMARK(TEXT("MotionInterp revoke authority %s %u"), *GetName(), AuthorityEpoch);
+}
+
+void UMotionInterpolatorComponent::WakeNetDormancy()
+{
+	NetRestTime = 0.0f;
+	AActor* Owner = GetOwner();
+	if (GetOwnerRole() == ROLE_Authority && IsValid(Owner) && Owner->NetDormancy > DORM_Awake)
+	{
+		Owner->SetNetDormancy(DORM_Awake);
+		MOTIONINTERP_COUNT(DormancyWakes, 1);
+	}
+}
+
+void UMotionInterpolatorComponent::UpdateNetDormancy(float DeltaTime, const USceneComponent& Component)
+{
+	AActor* Owner = GetOwner();
+	if (!IsValid(Owner) || Owner->NetDormancy == DORM_Never)
+	{
+		return;
+	}
+
+	// held or claimed actors send RPCs and change owners, they have to stay awake
+	// dormant actors drop multicasts, so connections without a channel keep it awake as well
+	const bool bIsAtRest = !Owner->HasNetOwner() && !bIsClaimedByClient && CurrentOwnershipDuration <= KINDA_SMALL_NUMBER && IsAtRest(Component)
+		&& !NeedsMulticastFallback();
+	if (!bIsAtRest)
+	{
+		WakeNetDormancy();
+		return;
+	}
+
+	NetRestTime += DeltaTime;
+	if (NetRestTime >= DormancyRestTime && Owner->NetDormancy != DORM_DormantAll)
+	{
+		Owner->SetNetDormancy(DORM_DormantAll);
+		MOTIONINTERP_COUNT(DormancySleeps, 1);
+	}
+}
+
+bool UMotionInterpolatorComponent::NeedsMulticastFallback() const
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	return IsValid(Subsystem) && Subsystem->HasConnectionsWithoutChannel();
+}
+
+bool UMotionInterpolatorComponent::IsAtRest(const USceneComponent& Component) const
+{
+	const UPrimitiveComponent* Primitive = Cast<const UPrimitiveComponent>(&Component);
+	const FVector AngularVelocity = IsValid(Primitive) ? Primitive->GetPhysicsAngularVelocityInDegrees() : FVector::ZeroVector;
+	return Component.GetComponentVelocity().SizeSquared() <= FMath::Square(RestLinearThreshold)
+		&& AngularVelocity.SizeSquared() <= FMath::Square(RestAngularThreshold);
+}
+
+bool UMotionInterpolatorComponent::IsSnapshotAtRest(const FMotionSnapshot& Snapshot) const
+{
+	return Snapshot.Velocity.SizeSquared() <= FMath::Square(RestLinearThreshold)
+		&& Snapshot.AngularVelocity.SizeSquared() <= FMath::Square(RestAngularThreshold);
+}
+
+void UMotionInterpolatorComponent::UpdateTickSleep(float DeltaTime, const FMotionInterpolatorTickContext& Context)
+{
+	USceneComponent* Component = Context.Component;
+	const AActor* Owner = GetOwner();
+	// claims, handoffs and delay blends count down on the tick
+	const bool bIsSettled = bAllowTickSleep && IsValid(Component) && IsValid(Owner) && !bIsClaimedByClient && !bHasClaimedAuthority
+		&& CurrentOwnershipDuration <= KINDA_SMALL_NUMBER && CurrentHightFreqSyncDuration == 0.0f && CurrentAuthorityBlendTime <= KINDA_SMALL_NUMBER
+		&& CurrentAdditionalNetworkDelay == TargetAdditionalNetworkDelay && !OnAdditionalDelayReached.IsBound()
+		&& !IsCorrectingImpact(Context.SyncedTime) && PendingImpacts.Num() == 0;
+	bool bIsIdle = false;
+	if (HadMovementAuthority)
+	{
+		// owning clients move what they hold every frame, only the server's own simulation sleeps
+		bIsIdle = bIsSettled && GetOwnerRole() == ROLE_Authority && !Owner->HasNetOwner() && Context.SyncedTime > AuthorityReleaseTime && IsAtRest(*Component);
+	}
+	else if (Context.bNeedsLookup)
+	{
+		// whatever is still buffered has to end in the pose that is shown now
+		if (bIsSettled && Context.OffBorder >= 0 && !Snapshots.IsEmpty() && IsSnapshotAtRest(Context.Snapshot))
+		{
+			const FMotionSnapshot Newest = Snapshots.GetLast();
+			bIsIdle = IsSnapshotAtRest(Newest) && !HasMovedSince(Context.Snapshot, Newest);
+		}
+	}
+	else
+	{
+		// proxies between two snaps have nothing new to tell
+		return;
+	}
+
+	if (!bIsIdle)
+	{
+		IdleTime = 0.0f;
+		return;
+	}
+
+	IdleTime += DeltaTime;
+	if (IdleTime >= TickSleepDelay)
+	{
+		StartTickSleep(*Component);
+	}
+}
+
+void UMotionInterpolatorComponent::StartTickSleep(USceneComponent& Component)
+{
+	bIsTickSleeping = true;
+	IdleTime = 0.0f;
+	INC_DWORD_STAT(STAT_MotionInterp_SleepingInterpolators);
+	TRACE_BOOKMARK(TEXT("MotionInterp tick sleep %s"), *GetName());
+
+	// the batch tick only walks awake interpolators
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (bIsBatchTicked && IsValid(Subsystem))
+	{
+		Subsystem->UnregisterInterpolator(this);
+	}
+	else
+	{
+		SetComponentTickEnabled(false);
+	}
+
+	if (!HadMovementAuthority)
+	{
+		// the resting pose exactly, not wherever interpolation towards it ended
+		FMotionSnapshot Resting = Snapshots.GetLast();
+		ApplySnapshot(Resting, Component);
+		ApplySyncTargets(Resting, Component);
+		return;
+	}
+
+	// proxies moving their own copy of the body would wake it, so only authorities listen for physics
+	UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(&Component);
+	if (IsValid(Primitive))
+	{
+		Primitive->OnComponentWake.AddUniqueDynamic(this, &UMotionInterpolatorComponent::OnSyncedComponentWake);
+		WakeEventComponent = Primitive;
+	}
+
+	AActor* Owner = GetOwner();
+	if (bDriveNetDormancy && IsValid(Owner) && Owner->NetDormancy != DORM_Never && Owner->NetDormancy != DORM_DormantAll && !NeedsMulticastFallback())
+	{
+		Owner->SetNetDormancy(DORM_DormantAll);
+		MOTIONINTERP_COUNT(DormancySleeps, 1);
+	}
+
+	UWorld* World = GetWorld();
+	if (IsValid(World))
+	{
+		World->GetTimerManager().SetTimer(KeepaliveTimerHandle, this, &UMotionInterpolatorComponent::SendKeepaliveSnapshot, FMath::Max(DeadReckoningKeepalivePeriod, 0.1f), true);
+	}
+	// receivers hold the newest snapshot, it has to be the resting one
+	SendKeepaliveSnapshot();
+}
+
+void UMotionInterpolatorComponent::SendKeepaliveSnapshot()
+{
+	USceneComponent* Component = GetComponentToSync();
+	if (!IsValid(Component))
+	{
+		return;
+	}
+
+	const double CurrentSyncedTime = GetSyncedTime();
+	FMotionSnapshot Snapshot(*Component, CurrentSyncedTime);
+	CaptureSyncTargets(*Component, Snapshot.Transforms);
+	Snapshot.AuthorityEpoch = AuthorityEpoch;
+	// bodies without wake events, or moved without physics, are only noticed here
+	if (!IsAtRest(*Component) || (bHasSentSnapshot && HasMovedSince(LastSentSnapshot, Snapshot)))
+	{
+		WakeTick();
+		return;
+	}
+
+	// a client without a channel joined while the actor slept, it only hears multicasts of an awake actor
+	if (bDriveNetDormancy && NeedsMulticastFallback())
+	{
+		WakeNetDormancy();
+	}
+
+	SendSnapshot(Snapshot);
+	LastSyncTime = CurrentSyncedTime;
+	LastSentSnapshot = Snapshot;
+	bHasSentSnapshot = true;
+	RecordRewindPose(Snapshot, *Component);
+}
+
+void UMotionInterpolatorComponent::OnSyncedComponentWake(UPrimitiveComponent* WakingComponent, FName BoneName)
+{
+	WakeTick();
+}
+
+void UMotionInterpolatorComponent::WakeTick()
+{
+	IdleTime = 0.0f;
+	if (!bIsTickSleeping)
+	{
+		return;
+	}
+
+	bIsTickSleeping = false;
+	DEC_DWORD_STAT(STAT_MotionInterp_SleepingInterpolators);
+	TRACE_BOOKMARK(TEXT("MotionInterp tick wake %s"), *GetName());
+
+	UWorld* World = GetWorld();
+	if (IsValid(World))
+	{
+		World->GetTimerManager().ClearTimer(KeepaliveTimerHandle);
+	}
+	UPrimitiveComponent* Primitive = WakeEventComponent.Get();
+	if (IsValid(Primitive))
+	{
+		Primitive->OnComponentWake.RemoveDynamic(this, &UMotionInterpolatorComponent::OnSyncedComponentWake);
+	}
+	WakeEventComponent = nullptr;
+
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (bIsBatchTicked && IsValid(Subsystem))
+	{
+		Subsystem->RegisterInterpolator(this);
+	}
+	else
+	{
+		SetComponentTickEnabled(true);
+	}
+}
+
+bool UMotionInterpolatorComponent::UpdateAuthorityEpoch(const FMotionSnapshot& Snapshot)
+{
+	if (!bHasAuthorityEpoch)
+	{
+		AuthorityEpoch = Snapshot.AuthorityEpoch;
+		bHasAuthorityEpoch = true;
+		return true;
+	}
+
+	if (Snapshot.AuthorityEpoch == AuthorityEpoch)
+	{
+		// senders never get their own snapshots back, so someone else won the claim of the same epoch
+		bHasClaimedAuthority = false;
+		return true;
+	}
+
+	if (!IsMotionSequenceNewer(Snapshot.AuthorityEpoch, AuthorityEpoch))
+	{
+		return false;
+	}
+
+	// the new authority's stream replaces whatever the previous one sent for the same time
+	AuthorityEpoch = Snapshot.AuthorityEpoch;
+	bHasClaimedAuthority = false;
+	Snapshots.RemoveFrom(Snapshot.Timestamp);
+	return true;
+}
+
+bool UMotionInterpolatorComponent::IsSampling() const
+{
+	return SampleRate > KINDA_SMALL_NUMBER;
+}
+
+void UMotionInterpolatorComponent::RecordSamples(const USceneComponent& Component, double SyncedTime)
+{
+	const double SampleInterval = 1.0 / SampleRate;
+	const int32 MaxSamples = FMath::Clamp(MaxSamplesPerSnapshot, 1, MaxMotionSnapshotSamples);
+	// after a hitch or a tick sleep the clock restarts, there is nothing to record for the time in between
+	if (!bIsSampleClockRunning || SyncedTime < NextSampleTime - SampleInterval || SyncedTime - NextSampleTime > MaxSamples * SampleInterval)
+	{
+		NextSampleTime = SyncedTime;
+		bIsSampleClockRunning = true;
+	}
+	if (SyncedTime < NextSampleTime)
+	{
+		return;
+	}
+
+	// the pose simulated on this frame, poses between frames would only be guesses
+	FMotionSnapshotSample& Sample = PendingSamples.AddDefaulted_GetRef();
+	Sample.Location = Component.GetComponentLocation();
+	Sample.Rotation = Component.GetComponentRotation();
+	Sample.Timestamp = SyncedTime;
+	CaptureSyncTargets(Component, Sample.Transforms);
+	if (PendingSamples.Num() > MaxSamples)
+	{
+		PendingSamples.RemoveAt(0, PendingSamples.Num() - MaxSamples, false);
+	}
+
+	// frames slower than the rate give one sample each, the clock doesn't catch up with a burst of them
+	NextSampleTime = FMath::Max(NextSampleTime + SampleInterval, SyncedTime + SampleInterval * 0.5);
+}
+
+void UMotionInterpolatorComponent::TakePendingSamples(FMotionSnapshot& Snapshot)
+{
+	if (PendingSamples.Num() == 0)
+	{
+		return;
+	}
+
+	// the snapshot itself stands for a sample on its timestamp
+	int32 NumSamples = PendingSamples.Num();
+	while (NumSamples > 0 && PendingSamples[NumSamples - 1].Timestamp >= Snapshot.Timestamp - KINDA_SMALL_NUMBER)
+	{
+		--NumSamples;
+	}
+	Snapshot.Samples.Reset(NumSamples);
+	for (int32 i = 0; i < NumSamples; ++i)
+	{
+		// samples are encoded against the snapshot's targets, ones recorded before the bindings changed are dropped
+		if (PendingSamples[i].Transforms.Num() == Snapshot.Transforms.Num())
+		{
+			Snapshot.Samples.Add(MoveTemp(PendingSamples[i]));
+		}
+	}
+	PendingSamples.Reset();
+}
+
+void UMotionInterpolatorComponent::ExpandSamples(const FMotionSnapshot& Snapshot, TArray<FMotionSnapshot>& OutSnapshots) const
+{
+	const int32 NumSamples = Snapshot.Samples.Num();
+	FMotionSnapshotSample SnapshotPose;
+	SnapshotPose.Location = Snapshot.Location;
+	SnapshotPose.Rotation = Snapshot.Rotation;
+	SnapshotPose.Timestamp = Snapshot.Timestamp;
+	const auto GetPose = [&Snapshot, &SnapshotPose, NumSamples](int32 Index) -> const FMotionSnapshotSample&
+	{
+		return Index < NumSamples ? Snapshot.Samples[Index] : SnapshotPose;
+	};
+
+	OutSnapshots.Reset(NumSamples);
+	for (int32 i = 0; i < NumSamples; ++i)
+	{
+		const FMotionSnapshotSample& Sample = Snapshot.Samples[i];
+		// central differences, the oldest sample only has a newer neighbour
+		const FMotionSnapshotSample& Previous = GetPose(FMath::Max(i - 1, 0));
+		const FMotionSnapshotSample& Next = GetPose(i + 1);
+		const float Duration = static_cast<float>(Next.Timestamp - Previous.Timestamp);
+
+		FMotionSnapshot& SampleSnapshot = OutSnapshots.AddDefaulted_GetRef();
+		SampleSnapshot.Location = Sample.Location;
+		SampleSnapshot.Rotation = Sample.Rotation;
+		SampleSnapshot.Timestamp = Sample.Timestamp;
+		SampleSnapshot.Transforms = Sample.Transforms;
+		SampleSnapshot.ArrivalTime = Snapshot.ArrivalTime;
+		SampleSnapshot.AuthorityEpoch = Snapshot.AuthorityEpoch;
+		if (Duration > KINDA_SMALL_NUMBER)
+		{
+			SampleSnapshot.Velocity = (Next.Location - Previous.Location) / Duration;
+			FVector Axis;
+			float Angle;
+			const FQuat Delta = Next.Rotation.Quaternion() * Previous.Rotation.Quaternion().Inverse();
+			Delta.GetNormalized().ToAxisAndAngle(Axis, Angle);
+			if (Angle > PI)
+			{
+				Angle -= 2.0f * PI;
+			}
+			SampleSnapshot.AngularVelocity = Axis * FMath::RadiansToDegrees(Angle) / Duration;
+		}
+	}
+}
+
+FMotionSnapshot UMotionInterpolatorComponent::Interpolate(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, double TargetTime)
+{
+	if (InterpolationMode == EMotionInterpolationMode::Hermite)
+	{
+		return HermiteInterpolate(FirstSnapshot, SecondSnapshot, TargetTime);
+	}
+
+	FMotionSnapshot Result;
+
+	// differences first, the absolute times only fit in doubles
+	float PredictionTime = static_cast<float>(TargetTime - FirstSnapshot.Timestamp);
+	float ReversePredictionTime = static_cast<float>(SecondSnapshot.Timestamp - TargetTime);
+
+	float Alpha = UKismetMathLibrary::NormalizeToRange(PredictionTime, 0.0f, static_cast<float>(SecondSnapshot.Timestamp - FirstSnapshot.Timestamp));
+
+	// Location of the object predicted from what we knew before
 	FVector ForwardPrediction = FirstSnapshot.Location + (FirstSnapshot.Velocity * PredictionTime);
 	// Location of the object calculated from what we know now
 	FVector BackwardPrediction = SecondSnapshot.Location + (SecondSnapshot.Velocity * ReversePredictionTime * -1);
@@ -370,6 +1509,7 @@ FMotionSnapshot UMotionInterpolatorComponent::Interpolate(const FMotionSnapshot&
 
 	Result.Velocity = FMath::Lerp(FirstSnapshot.Velocity, SecondSnapshot.Velocity, Alpha);
 	Result.AngularVelocity = FMath::Lerp(FirstSnapshot.AngularVelocity, SecondSnapshot.AngularVelocity, Alpha);
+	InterpolateTransforms(FirstSnapshot, SecondSnapshot, Alpha, Result);
 
 	Result.Timestamp = TargetTime;
 
@@ -383,15 +1523,35 @@ FMotionSnapshot UMotionInterpolatorComponent::SimpleInterpolate(const FMotionSna
 	Result.Rotation =FMath::Lerp(FirstSnapshot.Rotation, SecondSnapshot.Rotation, FMath::InterpSinInOut<float>(0.f, 1.f, Alpha));
 	Result.Velocity = FMath::Lerp(FirstSnapshot.Velocity, SecondSnapshot.Velocity, Alpha);
 	Result.AngularVelocity = FMath::Lerp(FirstSnapshot.AngularVelocity, SecondSnapshot.AngularVelocity, Alpha);
-	Result.Timestamp = FMath::Lerp(FirstSnapshot.Timestamp, SecondSnapshot.Timestamp, Alpha);
+	Result.Timestamp = FirstSnapshot.Timestamp + (SecondSnapshot.Timestamp - FirstSnapshot.Timestamp) * Alpha;
+	InterpolateTransforms(FirstSnapshot, SecondSnapshot, Alpha, Result);
 	return Result;
 }
 
-FMotionSnapshot UMotionInterpolatorComponent::Extrapolate(const FMotionSnapshot& Snapshot, float TargetTime)
+void UMotionInterpolatorComponent::InterpolateTransforms(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, float Alpha, FMotionSnapshot& Result)
 {
+	if (FirstSnapshot.Transforms.Num() != SecondSnapshot.Transforms.Num())
+	{
+		Result.Transforms = SecondSnapshot.Transforms;
+		return;
+	}
+	Result.Transforms.SetNum(SecondSnapshot.Transforms.Num());
+	for (int32 i = 0; i < Result.Transforms.Num(); ++i)
+	{
+		Result.Transforms[i] = FMotionSnapshotTransform::Lerp(FirstSnapshot.Transforms[i], SecondSnapshot.Transforms[i], Alpha);
+	}
+}
+
+FMotionSnapshot UMotionInterpolatorComponent::Extrapolate(const FMotionSnapshot& Snapshot, double TargetTime)
+{
+	if (InterpolationMode == EMotionInterpolationMode::Hermite)
+	{
+		return BoundedExtrapolate(Snapshot, TargetTime);
+	}
+
 	FMotionSnapshot Result = Snapshot;
 
-	float PredictionTime = TargetTime - Snapshot.Timestamp;
+	float PredictionTime = static_cast<float>(TargetTime - Snapshot.Timestamp);
 
 	Result.Location = Snapshot.Location + (Snapshot.Velocity * PredictionTime);
 	Result.Rotation = Snapshot.Rotation + FRotator::MakeFromEuler(Snapshot.AngularVelocity * PredictionTime);
@@ -400,56 +1560,265 @@ FMotionSnapshot UMotionInterpolatorComponent::Extrapolate(const FMotionSnapshot&
 	return Result;
 }
 
+bool UMotionInterpolatorComponent::HasDeadReckoningError(const FMotionSnapshot& Snapshot)
+{
+	if (!bHasSentSnapshot || Snapshot.Timestamp - LastSentSnapshot.Timestamp > DeadReckoningKeepalivePeriod)
+	{
+		return true;
+	}
+
+	// same model the receivers run past their newest snapshot, sync targets are held as sent
+	const FMotionSnapshot Predicted = UseExtrapolation ? Extrapolate(LastSentSnapshot, Snapshot.Timestamp) : LastSentSnapshot;
+	return HasMovedSince(Predicted, Snapshot);
+}
+
+bool UMotionInterpolatorComponent::HasMovedSince(const FMotionSnapshot& From, const FMotionSnapshot& To) const
+{
+	if (FVector::DistSquared(From.Location, To.Location) > FMath::Square(DeadReckoningLocationTolerance))
+	{
+		return true;
+	}
+	if (FMath::RadiansToDegrees(From.Rotation.Quaternion().AngularDistance(To.Rotation.Quaternion())) > DeadReckoningRotationTolerance)
+	{
+		return true;
+	}
+
+	// hands keep moving while the pawn stands still
+	if (To.Transforms.Num() != From.Transforms.Num())
+	{
+		return true;
+	}
+	for (int32 i = 0; i < To.Transforms.Num(); ++i)
+	{
+		const FMotionSnapshotTransform& Sent = From.Transforms[i];
+		const FMotionSnapshotTransform& Current = To.Transforms[i];
+		if (FVector::DistSquared(Sent.Location, Current.Location) > FMath::Square(DeadReckoningLocationTolerance)
+			|| FMath::RadiansToDegrees(Sent.Rotation.AngularDistance(Current.Rotation)) > DeadReckoningRotationTolerance)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+FMotionSnapshot UMotionInterpolatorComponent::HermiteInterpolate(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, double TargetTime) const
+{
+	const float Duration = static_cast<float>(SecondSnapshot.Timestamp - FirstSnapshot.Timestamp);
+	const float Alpha = Duration > KINDA_SMALL_NUMBER ? FMath::Clamp(static_cast<float>(TargetTime - FirstSnapshot.Timestamp) / Duration, 0.0f, 1.0f) : 1.0f;
+
+	FMotionSnapshot Result;
+
+	// tangents are the velocities scaled to the normalized [0, 1] segment
+	const FVector FirstTangent = FirstSnapshot.Velocity * Duration;
+	const FVector SecondTangent = SecondSnapshot.Velocity * Duration;
+	Result.Location = FMath::CubicInterp(FirstSnapshot.Location, FirstTangent, SecondSnapshot.Location, SecondTangent, Alpha);
+	Result.Velocity = Duration > KINDA_SMALL_NUMBER
+		? FMath::CubicInterpDerivative(FirstSnapshot.Location, FirstTangent, SecondSnapshot.Location, SecondTangent, Alpha) / Duration
+		: SecondSnapshot.Velocity;
+
+	// both predictions are exact at their own snapshot, the smoothstep blend keeps the angular velocity continuous there
+	const FQuat ForwardPrediction = IntegrateAngularVelocity(FirstSnapshot.Rotation.Quaternion(), FirstSnapshot.AngularVelocity, Alpha * Duration);
+	const FQuat BackwardPrediction = IntegrateAngularVelocity(SecondSnapshot.Rotation.Quaternion(), SecondSnapshot.AngularVelocity, (Alpha - 1.0f) * Duration);
+	Result.Rotation = FQuat::Slerp(ForwardPrediction, BackwardPrediction, FMath::SmoothStep(0.0f, 1.0f, Alpha)).Rotator();
+	Result.AngularVelocity = FMath::Lerp(FirstSnapshot.AngularVelocity, SecondSnapshot.AngularVelocity, Alpha);
+	InterpolateTransforms(FirstSnapshot, SecondSnapshot, Alpha, Result);
+
+	Result.Timestamp = TargetTime;
+	return Result;
+}
+
+FMotionSnapshot UMotionInterpolatorComponent::BoundedExtrapolate(const FMotionSnapshot& Snapshot, double TargetTime) const
+{
+	FMotionSnapshot Result = Snapshot;
+
+	const float PredictionTime = FMath::Clamp(static_cast<float>(TargetTime - Snapshot.Timestamp), 0.0f, MaxExtrapolationTime);
+	Result.Location = Snapshot.Location + (Snapshot.Velocity * PredictionTime).GetClampedToMaxSize(MaxExtrapolationDistance);
+	Result.Rotation = IntegrateAngularVelocity(Snapshot.Rotation.Quaternion(), Snapshot.AngularVelocity, PredictionTime).Rotator();
+
+	Result.Timestamp = TargetTime;
+	return Result;
+}
+
+FQuat UMotionInterpolatorComponent::IntegrateAngularVelocity(const FQuat& Rotation, const FVector& AngularVelocity, float Time)
+{
+	const float Speed = AngularVelocity.Size();
+	if (Speed < KINDA_SMALL_NUMBER || FMath::IsNearlyZero(Time))
+	{
+		return Rotation;
+	}
+	const FQuat Delta(AngularVelocity / Speed, FMath::DegreesToRadians(Speed * Time));
+	return (Delta * Rotation).GetNormalized();
+}
+
 USceneComponent* UMotionInterpolatorComponent::GetComponentToSync()
 {
 	if (IsValid(ComponentOverride))
 	{
 		return ComponentOverride;
 	}
-	if (!IsValid(ComponentToSync) || ComponentToSync->GetFName() != SyncedComponentName)
+	// bindings are cached, and only resolved again once a bound component is gone, like the root of a respawned child actor
+	bool bHasStaleBinding = ComponentToSync.IsStale();
+	for (const FSyncTargetBinding& Binding : SyncTargetBindings)
 	{
-		if (SyncedComponentName == NAME_None)
+		bHasStaleBinding |= Binding.Component.IsStale();
+	}
+	if (!bSyncBindingsResolved || bHasStaleBinding)
+	{
+		ResolveSyncBindings();
+	}
+	return ComponentToSync.Get();
+}
+
+USceneComponent* UMotionInterpolatorComponent::GetSyncedComponent() const
+{
+	return IsValid(ComponentOverride) ? ComponentOverride : ComponentToSync.Get();
+}
+
+void UMotionInterpolatorComponent::InvalidateSyncBindings()
+{
+	bSyncBindingsResolved = false;
+	WakeTick();
+}
+
+USceneComponent* UMotionInterpolatorComponent::FindSyncComponent(const AActor* Owner, FName ComponentName)
+{
+	if (!IsValid(Owner))
+	{
+		return nullptr;
+	}
+	if (ComponentName == NAME_None)
+	{
+		return Owner->GetRootComponent();
+	}
+	for (UActorComponent* Comp : Owner->GetComponents())
+	{
+		if (IsValid(Comp) && Comp->GetFName() == ComponentName)
 		{
-			ComponentToSync = GetOwner()->GetRootComponent();
+			if (UChildActorComponent* ChildActorComp = Cast<UChildActorComponent>(Comp))
+			{
+				AActor* ChildActor = ChildActorComp->GetChildActor();
+				return IsValid(ChildActor) ? ChildActor->GetRootComponent() : nullptr;
+			}
+			return Cast<USceneComponent>(Comp);
 		}
-		else
+	}
+	return nullptr;
+}
+
+void UMotionInterpolatorComponent::ResolveSyncBindings()
+{
+	const AActor* Owner = GetOwner();
+	ComponentToSync = FindSyncComponent(Owner, SyncedComponentName);
+
+	SyncTargetBindings.Reset(SyncTargets.Num());
+	for (const FMotionSyncTarget& Target : SyncTargets)
+	{
+		FSyncTargetBinding& Binding = SyncTargetBindings.AddDefaulted_GetRef();
+		USceneComponent* Component = FindSyncComponent(Owner, Target.ComponentName);
+		if (Target.BoneName == NAME_None)
+		{
+			Binding.Component = Component;
+		}
+		else if (USkinnedMeshComponent* Mesh = Cast<USkinnedMeshComponent>(Component))
 		{
-			for (UActorComponent* Comp : GetOwner()->GetComponents())
+			Binding.BoneIndex = Mesh->GetBoneIndex(Target.BoneName);
+			if (Binding.BoneIndex != INDEX_NONE)
 			{
-				if (Comp->GetFName() == SyncedComponentName)
+				Binding.Component = Mesh;
+				if (!Mesh->IsA<UPoseableMeshComponent>())
 				{
-					if (UChildActorComponent* ChildActorComp = Cast<UChildActorComponent>(Comp))
-					{
-						if (AActor* ChildActor = ChildActorComp->GetChildActor())
-						{
-							ComponentToSync = ChildActor->GetRootComponent();
-						}
-					}
-					else
-					{
-						ComponentToSync = Cast<USceneComponent>(Comp);
-					}
-					break;
+					// animation overwrites bone transforms every frame, there is nothing to set them on outside of the anim graph
+					UE_LOG(LogMotionInterpolator, Warning, TEXT("%s: sync target %s %s is a bone of a skeletal mesh, it is sent but not applied. Use a poseable mesh, or pose it in the anim instance from GetSyncTargetTransform"),
+						*GetPathName(), *Target.ComponentName.ToString(), *Target.BoneName.ToString());
 				}
 			}
 		}
+		if (!Binding.Component.IsValid())
+		{
+			UE_LOG(LogMotionInterpolator, Warning, TEXT("%s: sync target %s %s not found"), *GetPathName(), *Target.ComponentName.ToString(), *Target.BoneName.ToString());
+		}
 	}
-	return ComponentToSync;
+	AppliedSyncTargetTransforms.SetNum(SyncTargets.Num());
+	bSyncBindingsResolved = true;
 }
 
-float UMotionInterpolatorComponent::GetSnapshotsMaxDelay()
+void UMotionInterpolatorComponent::CaptureSyncTargets(const USceneComponent& Component, TArray<FMotionSnapshotTransform>& OutTransforms) const
 {
-	float MaxDelay = 0.0f;
-	if (Snapshots.Num() > 1)
+	const int32 NumTargets = FMath::Min(SyncTargetBindings.Num(), MaxMotionSyncTargets);
+	OutTransforms.SetNum(NumTargets);
+	const FTransform& BaseTransform = Component.GetComponentTransform();
+	for (int32 i = 0; i < NumTargets; ++i)
 	{
-		for (int32 i = 1; i < Snapshots.Num(); ++i)
+		const FSyncTargetBinding& Binding = SyncTargetBindings[i];
+		const USceneComponent* Target = Binding.Component.Get();
+		if (Target == nullptr)
 		{
-			const FMotionSnapshot& Snapshot = Snapshots[i];
-			const float Delay = Snapshot.ArrivalTime - Snapshot.Timestamp;
-			MaxDelay = FMath::Max(Delay, MaxDelay);
+			// unbound targets keep their slot, so the indices stay the same on every machine
+			OutTransforms[i] = FMotionSnapshotTransform();
+			continue;
 		}
+		const FTransform TargetTransform = Binding.BoneIndex != INDEX_NONE
+			? CastChecked<USkinnedMeshComponent>(Target)->GetBoneTransform(Binding.BoneIndex)
+			: Target->GetComponentTransform();
+		OutTransforms[i] = FMotionSnapshotTransform(TargetTransform.GetRelativeTransform(BaseTransform));
+	}
+}
+
+void UMotionInterpolatorComponent::ApplySyncTargets(const FMotionSnapshot& Snapshot, const USceneComponent& Component)
+{
+	const int32 NumTargets = FMath::Min(SyncTargetBindings.Num(), Snapshot.Transforms.Num());
+	const FTransform& BaseTransform = Component.GetComponentTransform();
+	for (int32 i = 0; i < NumTargets; ++i)
+	{
+		const FTransform TargetTransform = Snapshot.Transforms[i].ToTransform() * BaseTransform;
+		AppliedSyncTargetTransforms[i] = TargetTransform;
+
+		const FSyncTargetBinding& Binding = SyncTargetBindings[i];
+		USceneComponent* Target = Binding.Component.Get();
+		if (Target == nullptr)
+		{
+			continue;
+		}
+		if (Binding.BoneIndex == INDEX_NONE)
+		{
+			Target->SetWorldLocationAndRotation(TargetTransform.GetLocation(), TargetTransform.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics);
+		}
+		else if (UPoseableMeshComponent* PoseableMesh = Cast<UPoseableMeshComponent>(Target))
+		{
+			PoseableMesh->SetBoneTransformByName(SyncTargets[i].BoneName, TargetTransform, EBoneSpaces::WorldSpace);
+		}
+		// skeletal mesh bones were warned about when bound, their anim instance reads AppliedSyncTargetTransforms
+	}
+}
+
+void UMotionInterpolatorComponent::RecordRewindPose(const FMotionSnapshot& Pose, const USceneComponent& Component)
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (!IsValid(Subsystem) || !Subsystem->bRecordRewindHistory)
+	{
+		return;
+	}
+
+	const FTransform BaseTransform(Pose.Rotation, Pose.Location, Component.GetComponentScale());
+	const FMotionSnapshotTransform Base(BaseTransform);
+	const int32 NumTargets = FMath::Min(SyncTargets.Num(), MaxMotionSyncTargets);
+	TArray<FMotionSnapshotTransform, TInlineAllocator<MaxMotionSyncTargets + 1>> WorldTransforms;
+	WorldTransforms.Add(Base);
+	for (int32 i = 0; i < NumTargets; ++i)
+	{
+		WorldTransforms.Add(Pose.Transforms.IsValidIndex(i) ? FMotionSnapshotTransform(Pose.Transforms[i].ToTransform() * BaseTransform) : Base);
+	}
+	Subsystem->RecordRewindPose(this, Pose.Timestamp, WorldTransforms);
+}
+
+bool UMotionInterpolatorComponent::GetSyncTargetTransform(int32 TargetIndex, FTransform& OutTransform) const
+{
+	if (!AppliedSyncTargetTransforms.IsValidIndex(TargetIndex))
+	{
+		return false;
 	}
-	return MaxDelay;
+	OutTransform = AppliedSyncTargetTransforms[TargetIndex];
+	return true;
 }
 
 float UMotionInterpolatorComponent::GetLookupTimeOffset()
@@ -457,15 +1826,71 @@ float UMotionInterpolatorComponent::GetLookupTimeOffset()
 	return NetworkDelay + CurrentAdditionalNetworkDelay;
 }
 
-const AGameStateBase* UMotionInterpolatorComponent::GetGameState()
+FMotionSnapshotPrecision UMotionInterpolatorComponent::GetSnapshotPrecision() const
 {
-	if (!IsValid(CachedGameState))
+	FMotionSnapshotPrecision Precision;
+	switch (PrecisionProfile)
 	{
-		const UWorld* World = GetWorld();
-		if (IsValid(World) && IsValid(World->GetGameState()))
-		{
-			CachedGameState = World->GetGameState();
-		}
+	case EMotionPrecisionProfile::TrackedDevice:
+		Precision.Location = FMotionVectorPrecision(0.05f, 100000.0f);
+		Precision.Velocity = FMotionVectorPrecision(0.5f, 5000.0f);
+		Precision.AngularVelocity = FMotionVectorPrecision(1.0f, 3600.0f);
+		Precision.RotationBits = 13;
+		break;
+	case EMotionPrecisionProfile::PhysicsProp:
+		Precision.Location = FMotionVectorPrecision(0.1f, 100000.0f);
+		Precision.Velocity = FMotionVectorPrecision(1.0f, 5000.0f);
+		Precision.AngularVelocity = FMotionVectorPrecision(1.0f, 1440.0f);
+		Precision.RotationBits = 11;
+		break;
+	case EMotionPrecisionProfile::Custom:
+		Precision = CustomPrecision;
+		break;
+	default:
+		break;
+	}
+	for (const FMotionSyncTarget& Target : SyncTargets)
+	{
+		Precision.Transforms.Add(Target.Precision);
 	}
-	return CachedGameState;
+	Precision.NumSamples = IsSampling() ? FMath::Clamp(MaxSamplesPerSnapshot, 1, MaxMotionSnapshotSamples) : 0;
+	return Precision;
+}
+
+int32 UMotionInterpolatorComponent::GetBufferCapacity() const
+{
+	const int32 SnapshotCapacity = FMath::Max(BufferSize, 1);
+	return IsSampling() ? SnapshotCapacity * (FMath::Clamp(MaxSamplesPerSnapshot, 1, MaxMotionSnapshotSamples) + 1) : SnapshotCapacity;
+}
+
+int32 UMotionInterpolatorComponent::GetMaxSnapshotBits() const
+{
+	return GetSnapshotPrecision().GetMaxFullSnapshotBits();
+}
+
+FMotionSnapshotRecorder* UMotionInterpolatorComponent::GetRecorder() const
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	return IsValid(Subsystem) ? Subsystem->GetRecorder() : nullptr;
+}
+
+uint32 UMotionInterpolatorComponent::GetRecordingStreamId()
+{
+	if (RecordingStreamId == 0)
+	{
+		RecordingStreamId = FMotionSnapshotRecorder::GetStreamId(*this);
+	}
+	return RecordingStreamId;
+}
+
+UMotionInterpolatorSubsystem* UMotionInterpolatorComponent::GetSubsystem() const
+{
+	UWorld* World = GetWorld();
+	return IsValid(World) ? World->GetSubsystem<UMotionInterpolatorSubsystem>() : nullptr;
+}
+
+double UMotionInterpolatorComponent::GetSyncedTime() const
+{
+	const UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	return IsValid(Subsystem) ? Subsystem->GetSyncedTime() : 0.0;
 }
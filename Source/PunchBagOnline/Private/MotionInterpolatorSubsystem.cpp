@@ -0,0 +1,857 @@
+#include "MotionInterpolatorSubsystem.h"
+#include "MotionSyncChannelComponent.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/PackageMapClient.h"
+#include "GameFramework/GameStateBase.h"
+#include "Physics/PhysicsInterfaceCore.h"
+#include "Physics/PhysScene.h"
+#include "PhysicsEngine/BodyInstance.h"
+#include "Components/PrimitiveComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "PBOGameState.h"
+#include "PunchBagOnline.h"
+#include "MotionInterpolatorStats.h"
+
+static void LogMotionPrecisionReport(UWorld* World)
+{
+	const UEnum* ProfileEnum = StaticEnum<EMotionPrecisionProfile>();
+	const auto LogPrecision = [](const FString& Name, const FMotionSnapshotPrecision& Precision)
+	{
+		UE_LOG(LogMotionInterpolator, Display, TEXT("%s: location %d, velocity %d, angular velocity %d bits per axis, rotation 3 x %d bits, full snapshot <= %d bits, idle delta %d bits"),
+			*Name,
+			Precision.Location.GetBitsPerAxis(),
+			Precision.Velocity.GetBitsPerAxis(),
+			Precision.AngularVelocity.GetBitsPerAxis(),
+			Precision.RotationBits,
+			Precision.GetMaxFullSnapshotBits(),
+			Precision.GetMinDeltaSnapshotBits());
+	};
+
+	for (TObjectIterator<UMotionInterpolatorComponent> It; It; ++It)
+	{
+		if (It->GetWorld() == World)
+		{
+			LogPrecision(FString::Printf(TEXT("%s (%s)"), *It->GetPathName(World), *ProfileEnum->GetNameStringByValue(static_cast<int64>(It->PrecisionProfile))), It->GetSnapshotPrecision());
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorld MotionPrecisionReportCommand(
+	TEXT("MotionInterp.PrecisionReport"),
+	TEXT("Logs the snapshot bit sizes of every motion interpolator precision profile in the world"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogMotionPrecisionReport));
+
+static void StartMotionRecording(const TArray<FString>& Args, UWorld* World)
+{
+	UMotionInterpolatorSubsystem* Subsystem = IsValid(World) ? World->GetSubsystem<UMotionInterpolatorSubsystem>() : nullptr;
+	if (!IsValid(Subsystem))
+	{
+		return;
+	}
+	const FString Filename = Args.Num() > 0
+		? Args[0]
+		: FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MotionRecordings"), FDateTime::Now().ToString() + TEXT(".msr"));
+	if (Subsystem->StartRecording(Filename))
+	{
+		UE_LOG(LogMotionInterpolator, Display, TEXT("Recording motion snapshots to %s"), *Filename);
+	}
+	else
+	{
+		UE_LOG(LogMotionInterpolator, Warning, TEXT("Failed to record motion snapshots to %s"), *Filename);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs MotionRecordCommand(
+	TEXT("MotionInterp.Record"),
+	TEXT("Appends every motion snapshot of the world to a recording, as a new session. Args: [Filename], defaults to Saved/MotionRecordings"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartMotionRecording));
+
+static FAutoConsoleCommandWithWorld MotionStopRecordingCommand(
+	TEXT("MotionInterp.StopRecording"),
+	TEXT("Stops recording motion snapshots"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UMotionInterpolatorSubsystem* Subsystem = IsValid(World) ? World->GetSubsystem<UMotionInterpolatorSubsystem>() : nullptr;
+		if (IsValid(Subsystem))
+		{
+			Subsystem->StopRecording();
+		}
+	}));
+
+void FMotionInterpolatorBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (IsValid(Subsystem))
+	{
+		Subsystem->TickInterpolators(DeltaTime);
+	}
+}
+
+FString FMotionInterpolatorBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("FMotionInterpolatorBatchTickFunction");
+}
+
+void UMotionInterpolatorSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ClockEpoch = FPlatformTime::Seconds();
+}
+
+void UMotionInterpolatorSubsystem::Deinitialize()
+{
+	if (BatchTickFunction.IsTickFunctionRegistered())
+	{
+		BatchTickFunction.UnRegisterTickFunction();
+	}
+	StopRecording();
+	WaitForSnapshotDecodes();
+	PendingReceivers.Empty();
+	PendingPhysicsTargets.Empty();
+	for (const TPair<const UMotionInterpolatorComponent*, FMotionRewindHistory>& Pair : RewindHistories)
+	{
+		DEC_MEMORY_STAT_BY(STAT_MotionInterp_RewindHistoryMemory, Pair.Value.GetAllocatedSize());
+	}
+	RewindHistories.Empty();
+	Interpolators.Empty();
+	NetIdToInterpolator.Empty();
+	Channels.Empty();
+	InterestGrid.Empty();
+	Super::Deinitialize();
+}
+
+void UMotionInterpolatorSubsystem::RegisterInterpolator(UMotionInterpolatorComponent* Interpolator)
+{
+	Interpolators.AddUnique(Interpolator);
+	RegisterBatchTick();
+}
+
+void UMotionInterpolatorSubsystem::RegisterBatchTick()
+{
+	UWorld* World = GetWorld();
+	if (!BatchTickFunction.IsTickFunctionRegistered() && IsValid(World) && IsValid(World->PersistentLevel))
+	{
+		BatchTickFunction.Subsystem = this;
+		BatchTickFunction.bCanEverTick = true;
+		BatchTickFunction.TickGroup = TG_PostPhysics;
+		BatchTickFunction.RegisterTickFunction(World->PersistentLevel);
+	}
+}
+
+void UMotionInterpolatorSubsystem::UnregisterInterpolator(UMotionInterpolatorComponent* Interpolator)
+{
+	Interpolators.RemoveSwap(Interpolator);
+}
+
+void UMotionInterpolatorSubsystem::RegisterComponentTick(UMotionInterpolatorComponent* Interpolator)
+{
+	RegisterBatchTick();
+	if (BatchTickFunction.IsTickFunctionRegistered())
+	{
+		BatchTickFunction.AddPrerequisite(Interpolator, Interpolator->PrimaryComponentTick);
+	}
+}
+
+void UMotionInterpolatorSubsystem::UnregisterComponentTick(UMotionInterpolatorComponent* Interpolator)
+{
+	if (BatchTickFunction.IsTickFunctionRegistered())
+	{
+		BatchTickFunction.RemovePrerequisite(Interpolator, Interpolator->PrimaryComponentTick);
+	}
+}
+
+void UMotionInterpolatorSubsystem::TickInterpolators(float DeltaTime)
+{
+	MOTIONINTERP_SCOPE(BatchTick);
+
+	if (SentSnapshotsSinceTick > 0)
+	{
+		MOTIONINTERP_SET_FLOAT(BitsPerSnapshot, static_cast<double>(SentBitsSinceTick) / SentSnapshotsSinceTick);
+		SentSnapshotsSinceTick = 0;
+		SentBitsSinceTick = 0;
+	}
+
+	// received snapshots may wake sleeping interpolators, before the list is copied
+	DrainReceivedSnapshots();
+
+	const double CurrentSyncedTime = GetSyncedTime();
+
+	// authority sends, ownership and lookup times are resolved on the game thread
+	TickedInterpolators.Reset(Interpolators.Num());
+	for (UMotionInterpolatorComponent* Interpolator : Interpolators)
+	{
+		if (IsValid(Interpolator) && Interpolator->IsActive())
+		{
+			TickedInterpolators.Add(Interpolator);
+		}
+	}
+	TickContexts.Reset(TickedInterpolators.Num());
+	TickContexts.AddDefaulted(TickedInterpolators.Num());
+	for (int32 i = 0; i < TickedInterpolators.Num(); ++i)
+	{
+		TickedInterpolators[i]->PrepareMotionTick(DeltaTime, CurrentSyncedTime, TickContexts[i]);
+	}
+
+	// snapshot lookups only read the interpolator buffers, so they are safe to run in parallel
+	{
+		MOTIONINTERP_SCOPE(Lookups);
+		FMotionInterpolationBatch* Batch = bUseInterpolationBatch ? &InterpolationBatch : nullptr;
+		if (Batch != nullptr)
+		{
+			Batch->Reset(TickContexts.Num());
+		}
+		ParallelFor(TickContexts.Num(), [this, Batch](int32 Index)
+		{
+			FMotionInterpolatorTickContext& Context = TickContexts[Index];
+			if (Context.bNeedsLookup)
+			{
+				TickedInterpolators[Index]->ResolveMotionTick(Context, Batch, Index);
+			}
+		}, TickContexts.Num() < MinParallelLookups);
+		if (Batch != nullptr)
+		{
+			Batch->Interpolate();
+		}
+	}
+
+	float NetworkDelaySum = 0.0f;
+	float NetworkDelayMax = 0.0f;
+	float AdditionalDelaySum = 0.0f;
+	float OccupancySum = 0.0f;
+	// lookup tasks only flag what they did, stats are added up here on the game thread
+	int32 NumExtrapolations = 0;
+	for (int32 i = 0; i < TickedInterpolators.Num(); ++i)
+	{
+		UMotionInterpolatorComponent* Interpolator = TickedInterpolators[i];
+		if (IsValid(Interpolator))
+		{
+			if (TickContexts[i].bIsBatchInterpolated)
+			{
+				TickContexts[i].Snapshot = InterpolationBatch.GetResult(i);
+			}
+			NumExtrapolations += TickContexts[i].bIsExtrapolated ? 1 : 0;
+			Interpolator->FinishMotionTick(DeltaTime, TickContexts[i]);
+
+			NetworkDelaySum += Interpolator->NetworkDelay;
+			NetworkDelayMax = FMath::Max(NetworkDelayMax, Interpolator->NetworkDelay);
+			AdditionalDelaySum += Interpolator->GetAdditionalNetworkDelay();
+			OccupancySum += Interpolator->GetBufferOccupancy();
+		}
+	}
+
+	FlushPhysicsTargets();
+
+	const int32 NumTicked = TickedInterpolators.Num();
+	MOTIONINTERP_COUNT(Interpolators, NumTicked);
+	MOTIONINTERP_COUNT(Extrapolations, NumExtrapolations);
+	if (NumTicked > 0)
+	{
+		MOTIONINTERP_SET_FLOAT(NetworkDelayAvg, NetworkDelaySum / NumTicked);
+		MOTIONINTERP_SET_FLOAT(NetworkDelayMax, NetworkDelayMax);
+		MOTIONINTERP_SET_FLOAT(AdditionalDelayAvg, AdditionalDelaySum / NumTicked);
+		MOTIONINTERP_SET_FLOAT(BufferOccupancy, OccupancySum / NumTicked);
+	}
+}
+
+void UMotionInterpolatorSubsystem::QueuePhysicsTarget(FBodyInstance& BodyInstance, const FTransform& Transform, const FVector& Velocity, const FVector& AngularVelocity)
+{
+	FMotionPhysicsTarget& Target = PendingPhysicsTargets.AddDefaulted_GetRef();
+	Target.BodyInstance = &BodyInstance;
+	Target.Transform = Transform;
+	Target.Velocity = Velocity;
+	Target.AngularVelocity = AngularVelocity;
+}
+
+void UMotionInterpolatorSubsystem::FlushPhysicsTargets()
+{
+	if (PendingPhysicsTargets.Num() == 0)
+	{
+		return;
+	}
+
+	MOTIONINTERP_SCOPE(PhysicsTargets);
+	MOTIONINTERP_COUNT(PhysicsTargetsApplied, PendingPhysicsTargets.Num());
+
+	UWorld* World = GetWorld();
+	FPhysScene* PhysScene = IsValid(World) ? World->GetPhysicsScene() : nullptr;
+	if (PhysScene != nullptr)
+	{
+		FPhysicsCommand::ExecuteWrite(PhysScene, [this, PhysScene]()
+		{
+			for (const FMotionPhysicsTarget& Target : PendingPhysicsTargets)
+			{
+				const FPhysicsActorHandle& Handle = Target.BodyInstance->GetPhysicsActorHandle();
+				if (!FPhysicsInterface::IsValid(Handle))
+				{
+					continue;
+				}
+				if (FPhysicsInterface::IsKinematic_AssumesLocked(Handle))
+				{
+					// the scene spreads the target over substeps, the body sweeps instead of jumping into contacts
+					PhysScene->SetKinematicTarget_AssumesLocked(Target.BodyInstance, Target.Transform, true);
+				}
+				else
+				{
+					FPhysicsInterface::SetGlobalPose_AssumesLocked(Handle, Target.Transform);
+					FPhysicsInterface::SetLinearVelocity_AssumesLocked(Handle, Target.Velocity);
+					FPhysicsInterface::SetAngularVelocity_AssumesLocked(Handle, FMath::DegreesToRadians(Target.AngularVelocity));
+				}
+			}
+		});
+	}
+	PendingPhysicsTargets.Reset();
+}
+
+void UMotionInterpolatorSubsystem::RecordRewindPose(const UMotionInterpolatorComponent* Interpolator, double Time, TArrayView<const FMotionSnapshotTransform> Transforms)
+{
+	FMotionRewindHistory& History = RewindHistories.FindOrAdd(Interpolator);
+	const SIZE_T OldSize = History.GetAllocatedSize();
+	const float SampleRate = FMath::Max(RewindSampleRate, 1.0f);
+	History.Initialize(Transforms.Num(), FMath::CeilToInt(RewindHistoryDuration * SampleRate) + 1, 1.0f / SampleRate);
+	const SIZE_T NewSize = History.GetAllocatedSize();
+	if (NewSize != OldSize)
+	{
+		DEC_MEMORY_STAT_BY(STAT_MotionInterp_RewindHistoryMemory, OldSize);
+		INC_MEMORY_STAT_BY(STAT_MotionInterp_RewindHistoryMemory, NewSize);
+	}
+	History.Record(Time, Transforms);
+}
+
+void UMotionInterpolatorSubsystem::RemoveRewindHistory(const UMotionInterpolatorComponent* Interpolator)
+{
+	FMotionRewindHistory History;
+	if (RewindHistories.RemoveAndCopyValue(Interpolator, History))
+	{
+		DEC_MEMORY_STAT_BY(STAT_MotionInterp_RewindHistoryMemory, History.GetAllocatedSize());
+	}
+}
+
+const FMotionRewindHistory* UMotionInterpolatorSubsystem::FindRewindHistory(const UMotionInterpolatorComponent* Interpolator) const
+{
+	return RewindHistories.Find(Interpolator);
+}
+
+bool UMotionInterpolatorSubsystem::GetRewoundTransform(const UMotionInterpolatorComponent* Interpolator, int32 TargetIndex, double Time, FTransform& OutTransform) const
+{
+	const FMotionRewindHistory* History = FindRewindHistory(Interpolator);
+	// sleeping interpolators only record keepalives, they haven't moved since the newest one
+	return History != nullptr && History->Sample(TargetIndex + 1, Time, OutTransform, Interpolator->IsTickSleeping());
+}
+
+void UMotionInterpolatorSubsystem::ValidateHits(TArrayView<const FMotionHitQuery> Queries, TArray<FMotionHitResult>& OutResults) const
+{
+	MOTIONINTERP_SCOPE(HitValidation);
+	MOTIONINTERP_COUNT(HitsValidated, Queries.Num());
+
+	struct FPendingHit
+	{
+		const FMotionRewindHistory* StrikerHistory = nullptr;
+		const FMotionRewindHistory* StruckHistory = nullptr;
+		USceneComponent* StruckComponent = nullptr;
+		/** Sleeping interpolators rest in their newest recorded pose */
+		bool bIsStrikerSleeping = false;
+		bool bIsStruckSleeping = false;
+		/** Without scale, like the recorded poses */
+		FTransform StruckTransform;
+		/** Rewound contact point, moved into the current pose of the struck component */
+		FVector Point = FVector::ZeroVector;
+	};
+
+	OutResults.Reset(Queries.Num());
+	OutResults.AddDefaulted(Queries.Num());
+	TArray<FPendingHit> Pending;
+	Pending.SetNum(Queries.Num());
+
+	// components are resolved on the game thread
+	for (int32 i = 0; i < Queries.Num(); ++i)
+	{
+		const FMotionHitQuery& Query = Queries[i];
+		FPendingHit& Hit = Pending[i];
+		Hit.StrikerHistory = IsValid(Query.Striker) ? FindRewindHistory(Query.Striker) : nullptr;
+		Hit.StruckHistory = IsValid(Query.Struck) ? FindRewindHistory(Query.Struck) : nullptr;
+		USceneComponent* StruckComponent = IsValid(Query.Struck) ? Query.Struck->GetSyncedComponent() : nullptr;
+		if (Hit.StrikerHistory != nullptr && Hit.StruckHistory != nullptr && IsValid(StruckComponent))
+		{
+			Hit.StruckComponent = StruckComponent;
+			Hit.bIsStrikerSleeping = Query.Striker->IsTickSleeping();
+			Hit.bIsStruckSleeping = Query.Struck->IsTickSleeping();
+			Hit.StruckTransform = FTransform(StruckComponent->GetComponentQuat(), StruckComponent->GetComponentLocation());
+		}
+	}
+
+	// history lookups only read the histories, so they are safe to run in parallel
+	ParallelFor(Queries.Num(), [&Queries, &OutResults, &Pending](int32 Index)
+	{
+		const FMotionHitQuery& Query = Queries[Index];
+		FPendingHit& Hit = Pending[Index];
+		if (Hit.StruckComponent == nullptr)
+		{
+			return;
+		}
+		FTransform StrikerTransform;
+		FTransform StruckTransform;
+		if (!Hit.StrikerHistory->Sample(Query.StrikerTargetIndex + 1, Query.StrikerTime, StrikerTransform, Hit.bIsStrikerSleeping)
+			|| !Hit.StruckHistory->Sample(0, Query.StruckTime, StruckTransform, Hit.bIsStruckSleeping))
+		{
+			OutResults[Index].Validation = EMotionHitValidation::OutOfHistory;
+			Hit.StruckComponent = nullptr;
+			return;
+		}
+		// collision moves rigidly with its component, undoing the struck motion on the point is the same as rewinding the shapes
+		const FVector RewoundPoint = StrikerTransform.TransformPosition(Query.StrikerOffset);
+		Hit.Point = Hit.StruckTransform.TransformPosition(StruckTransform.InverseTransformPosition(RewoundPoint));
+	}, Queries.Num() < MinParallelLookups);
+
+	// collision queries need the physics scene, which belongs to the game thread
+	for (int32 i = 0; i < Queries.Num(); ++i)
+	{
+		const FPendingHit& Hit = Pending[i];
+		if (Hit.StruckComponent == nullptr)
+		{
+			continue;
+		}
+		FVector Closest = Hit.Point;
+		const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Hit.StruckComponent);
+		float Distance = IsValid(Primitive) ? Primitive->GetClosestPointOnCollision(Hit.Point, Closest) : -1.0f;
+		if (Distance < 0.0f)
+		{
+			// no collision to query, the bounds have to do
+			Closest = Hit.StruckComponent->Bounds.GetBox().GetClosestPointTo(Hit.Point);
+			Distance = FVector::Dist(Closest, Hit.Point);
+		}
+
+		FMotionHitResult& Result = OutResults[i];
+		Result.Distance = Distance - Queries[i].Radius;
+		Result.Location = Closest;
+		Result.Validation = Result.Distance <= Queries[i].Tolerance ? EMotionHitValidation::Hit : EMotionHitValidation::Miss;
+	}
+}
+
+FMotionHitResult UMotionInterpolatorSubsystem::ValidateHit(const FMotionHitQuery& Query) const
+{
+	TArray<FMotionHitResult> Results;
+	ValidateHits(MakeArrayView(&Query, 1), Results);
+	return Results[0];
+}
+
+void UMotionInterpolatorSubsystem::RecordSentSnapshots(int32 NumSnapshots, int32 NumBits)
+{
+	SentSnapshotsSinceTick += NumSnapshots;
+	SentBitsSinceTick += NumBits;
+	MOTIONINTERP_COUNT(BatchedSnapshotsSent, NumSnapshots);
+	MOTIONINTERP_COUNT(BatchedBitsSent, NumBits);
+}
+
+double UMotionInterpolatorSubsystem::GetSyncedTime() const
+{
+	if (SyncedTimeFrame != GFrameCounter)
+	{
+		const double LocalTime = GetLocalClockTime();
+		const double SyncedTime = IsClockSynchronized() ? (IsClockAuthority() ? LocalTime : ClockSync.GetServerTime(LocalTime)) : GetUnsynchronizedTime(LocalTime);
+		// slewing corrections may go back a little, steps go wherever the estimate is
+		if (SyncedTime >= CachedSyncedTime || CachedSyncedTime - SyncedTime > ClockSync.StepThreshold || SyncedTimeFrame == MAX_uint64)
+		{
+			CachedSyncedTime = SyncedTime;
+		}
+		SyncedTimeFrame = GFrameCounter;
+	}
+	return CachedSyncedTime;
+}
+
+double UMotionInterpolatorSubsystem::GetWorldSyncedTime(const UWorld* World)
+{
+	const UMotionInterpolatorSubsystem* Subsystem = IsValid(World) ? World->GetSubsystem<UMotionInterpolatorSubsystem>() : nullptr;
+	return IsValid(Subsystem) ? Subsystem->GetSyncedTime() : 0.0;
+}
+
+double UMotionInterpolatorSubsystem::GetLocalClockTime() const
+{
+	return bUseManualClock ? ManualClockTime : FPlatformTime::Seconds() - ClockEpoch;
+}
+
+double UMotionInterpolatorSubsystem::GetSyncedTimeAt(double PlatformTime) const
+{
+	const double LocalTime = bUseManualClock ? ManualClockTime : PlatformTime - ClockEpoch;
+	if (!IsClockSynchronized())
+	{
+		return GetUnsynchronizedTime(LocalTime);
+	}
+	return IsClockAuthority() ? LocalTime : ClockSync.GetServerTime(LocalTime);
+}
+
+double UMotionInterpolatorSubsystem::GetUnsynchronizedTime(double LocalTime) const
+{
+	// the game state's estimate is replicated with the game state, the local clock is only used before that
+	const UWorld* World = GetWorld();
+	const AGameStateBase* GameState = IsValid(World) ? World->GetGameState() : nullptr;
+	if (!IsValid(GameState))
+	{
+		return LocalTime;
+	}
+	// game time moved onto the server's synced clock, so the first clock sync only corrects the estimate instead of switching timelines
+	const APBOGameState* PBOGameState = Cast<APBOGameState>(GameState);
+	const double ClockOffset = IsValid(PBOGameState) ? PBOGameState->GetSyncedClockOffset() : 0.0;
+	return GameState->GetServerWorldTimeSeconds() + ClockOffset - (GetLocalClockTime() - LocalTime);
+}
+
+double UMotionInterpolatorSubsystem::GetPacketArrivalTime(UPackageMap* Map)
+{
+	UWorld* World = Map != nullptr ? Map->GetWorld() : nullptr;
+	const UMotionInterpolatorSubsystem* Subsystem = IsValid(World) ? World->GetSubsystem<UMotionInterpolatorSubsystem>() : nullptr;
+	if (!IsValid(Subsystem))
+	{
+		return 0.0;
+	}
+
+	// stamped on the game thread when TickDispatch reads the packet, the time it sat in the socket buffer before that isn't included
+	UPackageMapClient* ClientMap = Cast<UPackageMapClient>(Map);
+	const UNetConnection* Connection = ClientMap != nullptr ? ClientMap->GetConnection() : nullptr;
+	if (Connection == nullptr || Connection->LastReceiveRealtime <= 0.0)
+	{
+		return Subsystem->GetSyncedTime();
+	}
+	return Subsystem->GetSyncedTimeAt(Connection->LastReceiveRealtime);
+}
+
+void UMotionInterpolatorSubsystem::SetManualClockTime(double Time)
+{
+	bUseManualClock = true;
+	ManualClockTime = Time;
+}
+
+void UMotionInterpolatorSubsystem::ClearManualClock()
+{
+	bUseManualClock = false;
+}
+
+bool UMotionInterpolatorSubsystem::StartRecording(const FString& Filename)
+{
+	return Recorder.Open(Filename);
+}
+
+void UMotionInterpolatorSubsystem::StopRecording()
+{
+	if (Recorder.IsOpen())
+	{
+		UE_LOG(LogMotionInterpolator, Display, TEXT("Stopped recording motion snapshots, %lld records in %s"), Recorder.GetNumRecords(), *Recorder.GetFilename());
+		Recorder.Close();
+	}
+}
+
+bool UMotionInterpolatorSubsystem::IsClockAuthority() const
+{
+	const UWorld* World = GetWorld();
+	return !IsValid(World) || World->GetNetMode() != NM_Client;
+}
+
+uint16 UMotionInterpolatorSubsystem::RegisterNetId(UMotionInterpolatorComponent* Interpolator, uint16 NetId)
+{
+	if (NetId == 0)
+	{
+		// 0 is reserved for "not registered", skip ids still in use after wrapping around
+		do
+		{
+			++LastNetId;
+		}
+		while (LastNetId == 0 || NetIdToInterpolator.Contains(LastNetId));
+		NetId = LastNetId;
+	}
+	NetIdToInterpolator.Add(NetId, Interpolator);
+	return NetId;
+}
+
+void UMotionInterpolatorSubsystem::UnregisterNetId(uint16 NetId)
+{
+	NetIdToInterpolator.Remove(NetId);
+}
+
+UMotionInterpolatorComponent* UMotionInterpolatorSubsystem::FindInterpolatorByNetId(uint16 NetId) const
+{
+	const TWeakObjectPtr<UMotionInterpolatorComponent>* Interpolator = NetIdToInterpolator.Find(NetId);
+	return Interpolator != nullptr ? Interpolator->Get() : nullptr;
+}
+
+void UMotionInterpolatorSubsystem::RegisterChannel(UMotionSyncChannelComponent* Channel)
+{
+	Channels.AddUnique(Channel);
+}
+
+void UMotionInterpolatorSubsystem::UnregisterChannel(UMotionSyncChannelComponent* Channel)
+{
+	Channels.RemoveSwap(Channel);
+}
+
+UMotionSyncChannelComponent* UMotionInterpolatorSubsystem::GetLocalChannel() const
+{
+	for (UMotionSyncChannelComponent* Channel : Channels)
+	{
+		if (IsValid(Channel) && Channel->IsLocalChannel())
+		{
+			return Channel;
+		}
+	}
+	return nullptr;
+}
+
+UMotionSyncChannelComponent* UMotionInterpolatorSubsystem::FindChannelByConnection(const UNetConnection* Connection) const
+{
+	if (Connection == nullptr)
+	{
+		return nullptr;
+	}
+	for (UMotionSyncChannelComponent* Channel : Channels)
+	{
+		if (IsValid(Channel) && Channel->IsRemoteChannel() && Channel->GetNetConnection() == Connection)
+		{
+			return Channel;
+		}
+	}
+	return nullptr;
+}
+
+void UMotionInterpolatorSubsystem::ForwardSnapshot(uint16 NetId, const FMotionSnapshot& Snapshot, const UMotionSyncChannelComponent* SourceChannel, const FGuid& SenderGuid)
+{
+	GatherForwardTargets(Snapshot.Location, SourceChannel);
+	for (UMotionSyncChannelComponent* Channel : ForwardTargets)
+	{
+		Channel->QueueSnapshot(NetId, Snapshot);
+	}
+
+	// clients with a local channel drop the multicast, they get the batches
+	if (HasConnectionsWithoutChannel())
+	{
+		UMotionInterpolatorComponent* Interpolator = FindInterpolatorByNetId(NetId);
+		if (IsValid(Interpolator))
+		{
+			Interpolator->MulticastSendSnapshot(Snapshot, SenderGuid);
+		}
+	}
+}
+
+void UMotionInterpolatorSubsystem::ForwardImpact(uint16 NetId, const FMotionImpactEvent& Impact, const UMotionSyncChannelComponent* SourceChannel, const FGuid& SenderGuid)
+{
+	MOTIONINTERP_COUNT(ImpactsSent, 1);
+	GatherForwardTargets(Impact.Location, SourceChannel);
+	for (UMotionSyncChannelComponent* Channel : ForwardTargets)
+	{
+		Channel->ClientReceiveImpact(NetId, Impact);
+	}
+
+	if (HasConnectionsWithoutChannel())
+	{
+		UMotionInterpolatorComponent* Interpolator = FindInterpolatorByNetId(NetId);
+		if (IsValid(Interpolator))
+		{
+			Interpolator->MulticastSendImpact(Impact, SenderGuid);
+		}
+	}
+}
+
+bool UMotionInterpolatorSubsystem::HasConnectionsWithoutChannel()
+{
+	if (ChannelCoverageFrame == GFrameCounter)
+	{
+		return bHasConnectionsWithoutChannel;
+	}
+	ChannelCoverageFrame = GFrameCounter;
+	bHasConnectionsWithoutChannel = false;
+
+	const UWorld* World = GetWorld();
+	const UNetDriver* NetDriver = IsValid(World) ? World->GetNetDriver() : nullptr;
+	if (!IsValid(NetDriver))
+	{
+		return false;
+	}
+	for (const UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (IsValid(Connection) && FindChannelByConnection(Connection) == nullptr)
+		{
+			// a game mode without channels, or a player that just joined
+			UE_LOG(LogMotionInterpolator, Verbose, TEXT("%s has no motion sync channel, falling back to multicasts"), *Connection->GetName());
+			bHasConnectionsWithoutChannel = true;
+			break;
+		}
+	}
+	return bHasConnectionsWithoutChannel;
+}
+
+void UMotionInterpolatorSubsystem::GatherForwardTargets(const FVector& Location, const UMotionSyncChannelComponent* SourceChannel)
+{
+	ForwardTargets.Reset();
+	if (!bUseInterestManagement)
+	{
+		for (UMotionSyncChannelComponent* Channel : Channels)
+		{
+			if (Channel != SourceChannel && IsValid(Channel) && Channel->IsRemoteChannel())
+			{
+				ForwardTargets.Add(Channel);
+			}
+		}
+		return;
+	}
+
+	UpdateInterestGrid();
+
+	// cells are InterestRadius wide, so every interested channel is in one of the 27 neighbouring cells
+	const FIntVector Cell = GetInterestCell(Location);
+	for (int32 X = -1; X <= 1; ++X)
+	{
+		for (int32 Y = -1; Y <= 1; ++Y)
+		{
+			for (int32 Z = -1; Z <= 1; ++Z)
+			{
+				const TArray<UMotionSyncChannelComponent*, TInlineAllocator<4>>* CellChannels = InterestGrid.Find(Cell + FIntVector(X, Y, Z));
+				if (CellChannels == nullptr)
+				{
+					continue;
+				}
+				for (UMotionSyncChannelComponent* Channel : *CellChannels)
+				{
+					if (Channel != SourceChannel && IsValid(Channel) && Channel->GetInterestDistance(Location) <= InterestRadius)
+					{
+						ForwardTargets.AddUnique(Channel);
+					}
+				}
+			}
+		}
+	}
+}
+
+void UMotionInterpolatorSubsystem::UpdateInterestGrid()
+{
+	if (InterestGridFrame == GFrameCounter)
+	{
+		return;
+	}
+	InterestGridFrame = GFrameCounter;
+
+	InterestGrid.Reset();
+	for (UMotionSyncChannelComponent* Channel : Channels)
+	{
+		if (IsValid(Channel) && Channel->IsRemoteChannel())
+		{
+			Channel->UpdateInterestPoints();
+			for (const FVector& InterestPoint : Channel->GetInterestPoints())
+			{
+				InterestGrid.FindOrAdd(GetInterestCell(InterestPoint)).AddUnique(Channel);
+			}
+		}
+	}
+}
+
+FIntVector UMotionInterpolatorSubsystem::GetInterestCell(const FVector& Location) const
+{
+	const float CellSize = FMath::Max(InterestRadius, 1.0f);
+	return FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void UMotionInterpolatorSubsystem::DecodeReceivedSnapshots(FMotionSnapshotDecodeBatch&& Batch, FGraphEventRef& InOutChannelTask)
+{
+	if (Batch.Decodes.Num() == 0)
+	{
+		return;
+	}
+	// drains happen in the batch tick, even without batched interpolators
+	RegisterBatchTick();
+
+	const bool bIsChannelTaskPending = InOutChannelTask.IsValid() && !InOutChannelTask->IsComplete();
+	if (!bDecodeSnapshotsAsync || (Batch.Decodes.Num() < MinAsyncDecodes && !bIsChannelTaskPending))
+	{
+		DecodeSnapshots(Batch);
+		return;
+	}
+
+	// drains don't wait for the task, its snapshots go out with the first drain after it finished.
+	// Interpolators that end play and the subsystem wait for every pending task, they are written to by it
+	FGraphEventArray Prerequisites;
+	if (bIsChannelTaskPending)
+	{
+		Prerequisites.Add(InOutChannelTask);
+	}
+	InOutChannelTask = FFunctionGraphTask::CreateAndDispatchWhenReady([this, Batch = MoveTemp(Batch)]()
+	{
+		DecodeSnapshots(Batch);
+	}, TStatId(), &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+	PendingDecodeTasks.Add(InOutChannelTask);
+}
+
+void UMotionInterpolatorSubsystem::DecodeSnapshots(const FMotionSnapshotDecodeBatch& Batch)
+{
+	MOTIONINTERP_SCOPE(DecodeSnapshots);
+
+	for (const FMotionSnapshotDecode& Decode : Batch.Decodes)
+	{
+		FMotionReceivedSnapshot Received;
+		Received.Snapshot = Decode.Quantized.Dequantize(Decode.Precision);
+		Received.Snapshot.AuthorityEpoch = Decode.AuthorityEpoch;
+		Received.Snapshot.ArrivalTime = Batch.ArrivalTime;
+		Received.SourceChannel = Batch.SourceChannel;
+		if (Decode.Interpolator->EnqueueReceivedSnapshot(MoveTemp(Received)))
+		{
+			PendingReceivers.Enqueue(Decode.WeakInterpolator);
+		}
+	}
+}
+
+void UMotionInterpolatorSubsystem::WaitForSnapshotDecodes()
+{
+	if (PendingDecodeTasks.Num() > 0)
+	{
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(PendingDecodeTasks, ENamedThreads::GameThread);
+		PendingDecodeTasks.Reset();
+	}
+}
+
+void UMotionInterpolatorSubsystem::DrainReceivedSnapshots()
+{
+	// decode tasks may still run and queue snapshots while this drains, whatever they queue later waits for the next drain
+	PendingDecodeTasks.RemoveAllSwap([](const FGraphEventRef& Task)
+	{
+		return Task->IsComplete();
+	});
+
+	TWeakObjectPtr<UMotionInterpolatorComponent> Receiver;
+	while (PendingReceivers.Dequeue(Receiver))
+	{
+		UMotionInterpolatorComponent* Interpolator = Receiver.Get();
+		if (!IsValid(Interpolator))
+		{
+			continue;
+		}
+		FMotionReceivedSnapshot Received;
+		while (Interpolator->DequeueReceivedSnapshot(Received))
+		{
+			DeliverSnapshot(*Interpolator, Received.Snapshot, Received.SourceChannel.Get());
+		}
+	}
+}
+
+void UMotionInterpolatorSubsystem::DeliverSnapshot(UMotionInterpolatorComponent& Interpolator, const FMotionSnapshot& Snapshot, UMotionSyncChannelComponent* SourceChannel)
+{
+	// the connection went away since
+	if (!IsValid(SourceChannel))
+	{
+		return;
+	}
+
+	if (SourceChannel->GetOwnerRole() == ROLE_Authority)
+	{
+		// owning connections and authority claims, see UMotionInterpolatorComponent::ClaimAuthority
+		if (!Interpolator.AcceptSnapshotFrom(Snapshot, SourceChannel->GetNetConnection()))
+		{
+			return;
+		}
+		ForwardSnapshot(Interpolator.GetSyncNetId(), Snapshot, SourceChannel);
+	}
+	Interpolator.ReceiveSnapshot(Snapshot, SourceChannel);
+}
@@ -0,0 +1,97 @@
+#include "MotionRewindHistory.h"
+
+void FMotionRewindHistory::Initialize(int32 InNumTransforms, int32 InCapacity, float InMinSampleInterval)
+{
+	InNumTransforms = FMath::Max(InNumTransforms, 1);
+	InCapacity = FMath::Max(InCapacity, 2);
+	MinSampleInterval = FMath::Max(InMinSampleInterval, 0.0f);
+	if (InNumTransforms == NumTransforms && InCapacity == Times.Num())
+	{
+		return;
+	}
+
+	NumTransforms = InNumTransforms;
+	Times.SetNumZeroed(InCapacity);
+	Times.Shrink();
+	Poses.SetNum(InCapacity * NumTransforms);
+	Poses.Shrink();
+	Reset();
+}
+
+void FMotionRewindHistory::Reset()
+{
+	Head = 0;
+	Count = 0;
+}
+
+void FMotionRewindHistory::Record(double Time, TArrayView<const FMotionSnapshotTransform> Transforms)
+{
+	if (Times.Num() == 0 || Transforms.Num() == 0 || (Count > 0 && Time < GetNewestTime() + MinSampleInterval))
+	{
+		return;
+	}
+
+	int32 Slot;
+	if (Count == Times.Num())
+	{
+		Slot = Head;
+		Head = (Head + 1) % Times.Num();
+	}
+	else
+	{
+		Slot = GetSlot(Count);
+		++Count;
+	}
+
+	Times[Slot] = Time;
+	FMotionSnapshotTransform* SlotPoses = &Poses[Slot * NumTransforms];
+	for (int32 i = 0; i < NumTransforms; ++i)
+	{
+		SlotPoses[i] = Transforms.IsValidIndex(i) ? Transforms[i] : Transforms[0];
+	}
+}
+
+bool FMotionRewindHistory::Sample(int32 TransformIndex, double Time, FTransform& OutTransform, bool bHoldNewest) const
+{
+	if (Count == 0 || TransformIndex < 0 || TransformIndex >= NumTransforms || Time < GetOldestTime())
+	{
+		return false;
+	}
+
+	if (Time >= GetNewestTime())
+	{
+		if (!bHoldNewest && Time - GetNewestTime() > MinSampleInterval + KINDA_SMALL_NUMBER)
+		{
+			return false;
+		}
+		OutTransform = GetPose(Count - 1, TransformIndex).ToTransform();
+		return true;
+	}
+
+	// Time is inside the window, so both neighbours exist
+	const int32 SecondIndex = UpperBound(Time);
+	const double FirstTime = GetTime(SecondIndex - 1);
+	const float Duration = static_cast<float>(GetTime(SecondIndex) - FirstTime);
+	const float Alpha = Duration > KINDA_SMALL_NUMBER ? static_cast<float>(Time - FirstTime) / Duration : 1.0f;
+	OutTransform = FMotionSnapshotTransform::Lerp(GetPose(SecondIndex - 1, TransformIndex), GetPose(SecondIndex, TransformIndex), Alpha).ToTransform();
+	return true;
+}
+
+int32 FMotionRewindHistory::UpperBound(double Time) const
+{
+	int32 Low = 0;
+	int32 High = Count;
+	while (Low < High)
+	{
+		const int32 Middle = Low + (High - Low) / 2;
+		if (GetTime(Middle) <= Time)
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+	return Low;
+}
@@ -0,0 +1,156 @@
+#include "MotionSnapshotBuffer.h"
+#include "MotionInterpolatorComponent.h"
+
+void FMotionSnapshotBuffer::SetCapacity(int32 InCapacity)
+{
+	InCapacity = FMath::Max(InCapacity, 1);
+	if (InCapacity == Entries.Capacity())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < Entries.Num() - InCapacity; ++i)
+	{
+		FreeTargetBlock(Entries[i].TargetBlock);
+	}
+	Entries.SetCapacity(InCapacity);
+}
+
+bool FMotionSnapshotBuffer::Add(const FMotionSnapshot& Snapshot)
+{
+	FMotionBufferedSnapshot Entry;
+	Entry.Location = Snapshot.Location;
+	Entry.Rotation = Snapshot.Rotation;
+	for (int32 i = 0; i < 3; ++i)
+	{
+		Entry.Velocity[i] = FFloat16(Snapshot.Velocity[i]);
+		Entry.AngularVelocity[i] = FFloat16(Snapshot.AngularVelocity[i]);
+	}
+	Entry.Timestamp = Snapshot.Timestamp;
+
+	const int32 NumTargets = FMath::Min(Snapshot.Transforms.Num(), MaxMotionSyncTargets);
+	if (NumTargets > 0)
+	{
+		// the new block is taken before the oldest entry gives its block back
+		ReserveTargetBlocks(Entries.Capacity() + 1, NumTargets);
+		Entry.TargetBlock = FreeTargetBlocks.Pop(false);
+		Entry.NumTargets = static_cast<uint8>(NumTargets);
+		FMotionSnapshotTransform* Block = &TargetPool[Entry.TargetBlock * TargetStride];
+		for (int32 i = 0; i < NumTargets; ++i)
+		{
+			Block[i] = Snapshot.Transforms[i];
+		}
+	}
+
+	const bool bAdded = Entries.Add(Entry, [this](const FMotionBufferedSnapshot& Removed)
+	{
+		FreeTargetBlock(Removed.TargetBlock);
+	});
+	if (!bAdded)
+	{
+		FreeTargetBlock(Entry.TargetBlock);
+	}
+	return bAdded;
+}
+
+void FMotionSnapshotBuffer::Empty()
+{
+	for (int32 i = 0; i < Entries.Num(); ++i)
+	{
+		FreeTargetBlock(Entries[i].TargetBlock);
+	}
+	Entries.Empty();
+}
+
+void FMotionSnapshotBuffer::RemoveFrom(double Time)
+{
+	for (int32 i = Entries.LowerBound(Time); i < Entries.Num(); ++i)
+	{
+		FreeTargetBlock(Entries[i].TargetBlock);
+	}
+	Entries.RemoveFrom(Time);
+}
+
+TArrayView<const FMotionSnapshotTransform> FMotionSnapshotBuffer::GetTargets(int32 Index) const
+{
+	const FMotionBufferedSnapshot& Entry = Entries[Index];
+	if (Entry.TargetBlock == INDEX_NONE)
+	{
+		return TArrayView<const FMotionSnapshotTransform>();
+	}
+	return TArrayView<const FMotionSnapshotTransform>(&TargetPool[Entry.TargetBlock * TargetStride], Entry.NumTargets);
+}
+
+void FMotionSnapshotBuffer::GetSnapshot(int32 Index, FMotionSnapshot& OutSnapshot) const
+{
+	const FMotionBufferedSnapshot& Entry = Entries[Index];
+	OutSnapshot.Location = Entry.Location;
+	OutSnapshot.Rotation = Entry.Rotation;
+	OutSnapshot.Velocity = Entry.GetVelocity();
+	OutSnapshot.AngularVelocity = Entry.GetAngularVelocity();
+	OutSnapshot.Timestamp = Entry.Timestamp;
+	OutSnapshot.Transforms.Reset();
+	OutSnapshot.Transforms.Append(GetTargets(Index));
+	OutSnapshot.ArrivalTime = 0.0;
+	OutSnapshot.AuthorityEpoch = 0;
+}
+
+FMotionSnapshot FMotionSnapshotBuffer::GetSnapshot(int32 Index) const
+{
+	FMotionSnapshot Snapshot;
+	GetSnapshot(Index, Snapshot);
+	return Snapshot;
+}
+
+FMotionSnapshot FMotionSnapshotBuffer::GetLast() const
+{
+	return GetSnapshot(Entries.Num() - 1);
+}
+
+SIZE_T FMotionSnapshotBuffer::GetAllocatedSize() const
+{
+	return Entries.GetAllocatedSize() + TargetPool.GetAllocatedSize() + FreeTargetBlocks.GetAllocatedSize();
+}
+
+void FMotionSnapshotBuffer::ReserveTargetBlocks(int32 NumBlocks, int32 Stride)
+{
+	if (NumBlocks <= NumTargetBlocks && Stride <= TargetStride)
+	{
+		return;
+	}
+
+	NumBlocks = FMath::Max(NumBlocks, NumTargetBlocks);
+	Stride = FMath::Max(Stride, TargetStride);
+	if (Stride != TargetStride && TargetPool.Num() > 0)
+	{
+		TArray<FMotionSnapshotTransform> NewPool;
+		NewPool.SetNum(NumBlocks * Stride);
+		for (int32 Block = 0; Block < NumTargetBlocks; ++Block)
+		{
+			for (int32 i = 0; i < TargetStride; ++i)
+			{
+				NewPool[Block * Stride + i] = TargetPool[Block * TargetStride + i];
+			}
+		}
+		TargetPool = MoveTemp(NewPool);
+	}
+	else
+	{
+		TargetPool.SetNum(NumBlocks * Stride);
+	}
+
+	for (int32 Block = NumTargetBlocks; Block < NumBlocks; ++Block)
+	{
+		FreeTargetBlocks.Add(Block);
+	}
+	NumTargetBlocks = NumBlocks;
+	TargetStride = Stride;
+}
+
+void FMotionSnapshotBuffer::FreeTargetBlock(int32 Block)
+{
+	if (Block != INDEX_NONE)
+	{
+		FreeTargetBlocks.Add(Block);
+	}
+}
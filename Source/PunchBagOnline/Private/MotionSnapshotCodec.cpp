@@ -0,0 +1,437 @@
+#include "MotionSnapshotCodec.h"
+
+static constexpr double MotionTimestampScale = 1000.0;
+/** Keeps deltas between two clamped values inside int32 */
+static constexpr int32 MotionQuantizedLimit = (1 << 30) - 1;
+/** Bits used to send the bit width of a packed int group */
+static constexpr int32 PackedIntsHeaderBits = 6;
+
+static int32 GetMaxQuantizedValue(const FMotionVectorPrecision& Precision)
+{
+	return static_cast<int32>(FMath::Min<double>(FMath::CeilToDouble(Precision.MaxValue / Precision.Step), MotionQuantizedLimit));
+}
+
+static FIntVector QuantizeVector(const FVector& Vector, const FMotionVectorPrecision& Precision)
+{
+	const int32 MaxValue = GetMaxQuantizedValue(Precision);
+	return FIntVector(
+		FMath::Clamp(FMath::RoundToInt(Vector.X / Precision.Step), -MaxValue, MaxValue),
+		FMath::Clamp(FMath::RoundToInt(Vector.Y / Precision.Step), -MaxValue, MaxValue),
+		FMath::Clamp(FMath::RoundToInt(Vector.Z / Precision.Step), -MaxValue, MaxValue));
+}
+
+static FVector DequantizeVector(const FIntVector& Vector, const FMotionVectorPrecision& Precision)
+{
+	return FVector(Vector.X * Precision.Step, Vector.Y * Precision.Step, Vector.Z * Precision.Step);
+}
+
+static uint32 ZigZagEncode(int32 Value)
+{
+	return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+}
+
+static int32 ZigZagDecode(uint32 Value)
+{
+	return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1);
+}
+
+static void SerializePackedInts(FArchive& Ar, int32* Values, int32 NumValues)
+{
+	uint32 NumBits = 0;
+	if (Ar.IsSaving())
+	{
+		uint32 MaxValue = 0;
+		for (int32 i = 0; i < NumValues; ++i)
+		{
+			MaxValue |= ZigZagEncode(Values[i]);
+		}
+		NumBits = 32 - FMath::CountLeadingZeros(MaxValue);
+	}
+	// 0..32 bits per value
+	Ar.SerializeBits(&NumBits, PackedIntsHeaderBits);
+
+	if (NumBits > 32)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	for (int32 i = 0; i < NumValues; ++i)
+	{
+		uint32 Encoded = Ar.IsSaving() ? ZigZagEncode(Values[i]) : 0;
+		if (NumBits > 0)
+		{
+			Ar.SerializeBits(&Encoded, NumBits);
+		}
+		Values[i] = ZigZagDecode(Encoded);
+	}
+}
+
+static void SerializeQuantizedVector(FArchive& Ar, FIntVector& Vector)
+{
+	int32 Values[3] = { Vector.X, Vector.Y, Vector.Z };
+	SerializePackedInts(Ar, Values, 3);
+	Vector = FIntVector(Values[0], Values[1], Values[2]);
+}
+
+static int32 GetRotationComponentBits(int32 RotationBits)
+{
+	return FMath::Clamp(RotationBits, 4, 20);
+}
+
+int32 FMotionVectorPrecision::GetBitsPerAxis() const
+{
+	return 32 - FMath::CountLeadingZeros(ZigZagEncode(-GetMaxQuantizedValue(*this)));
+}
+
+const FMotionTransformPrecision& FMotionSnapshotPrecision::GetTransformPrecision(int32 Index) const
+{
+	static const FMotionTransformPrecision DefaultPrecision;
+	return Transforms.IsValidIndex(Index) ? Transforms[Index] : DefaultPrecision;
+}
+
+int32 FMotionSnapshotPrecision::GetMaxFullSnapshotBits() const
+{
+	int32 Bits = (PackedIntsHeaderBits + 3 * Location.GetBitsPerAxis())
+		+ (2 + PackedIntsHeaderBits + 3 * GetRotationComponentBits(RotationBits))
+		+ (PackedIntsHeaderBits + 3 * Velocity.GetBitsPerAxis())
+		+ (PackedIntsHeaderBits + 3 * AngularVelocity.GetBitsPerAxis())
+		+ (PackedIntsHeaderBits + 32)
+		+ (PackedIntsHeaderBits + 32 - FMath::CountLeadingZeros(ZigZagEncode(MaxMotionSyncTargets)))
+		+ (PackedIntsHeaderBits + 32 - FMath::CountLeadingZeros(ZigZagEncode(MaxMotionSnapshotSamples)));
+	for (const FMotionTransformPrecision& Transform : Transforms)
+	{
+		Bits += (PackedIntsHeaderBits + 3 * Transform.Location.GetBitsPerAxis())
+			+ (2 + PackedIntsHeaderBits + 3 * GetRotationComponentBits(Transform.RotationBits));
+	}
+	// differences of two clamped values take one more bit
+	int32 SampleBits = (PackedIntsHeaderBits + 3 * (Location.GetBitsPerAxis() + 1))
+		+ (2 + PackedIntsHeaderBits + 3 * (GetRotationComponentBits(RotationBits) + 1))
+		+ (PackedIntsHeaderBits + 32);
+	for (const FMotionTransformPrecision& Transform : Transforms)
+	{
+		SampleBits += (PackedIntsHeaderBits + 3 * (Transform.Location.GetBitsPerAxis() + 1))
+			+ (2 + PackedIntsHeaderBits + 3 * (GetRotationComponentBits(Transform.RotationBits) + 1));
+	}
+	Bits += FMath::Clamp(NumSamples, 0, MaxMotionSnapshotSamples) * SampleBits;
+	return Bits;
+}
+
+int32 FMotionSnapshotPrecision::GetMinDeltaSnapshotBits() const
+{
+	// every packed group down to its header, plus the transform and sample counts
+	return 5 * PackedIntsHeaderBits + 2 + 2 * PackedIntsHeaderBits + Transforms.Num() * (2 * PackedIntsHeaderBits + 2);
+}
+
+void FSmallestThreeQuat::Quantize(const FQuat& Quat, int32 Bits, FIntVector& OutComponents, int32& OutLargest)
+{
+	const FQuat Normalized = Quat.GetNormalized();
+	const float Components[4] = { Normalized.X, Normalized.Y, Normalized.Z, Normalized.W };
+
+	OutLargest = 0;
+	for (int32 i = 1; i < 4; ++i)
+	{
+		if (FMath::Abs(Components[i]) > FMath::Abs(Components[OutLargest]))
+		{
+			OutLargest = i;
+		}
+	}
+
+	// q and -q are the same rotation, flip so the dropped component is positive
+	const float Sign = Components[OutLargest] < 0.0f ? -1.0f : 1.0f;
+	const int32 MaxValue = (1 << (Bits - 1)) - 1;
+	const float Scale = MaxValue / HALF_SQRT_2;
+
+	int32 Smallest[3];
+	for (int32 i = 0, j = 0; i < 4; ++i)
+	{
+		if (i != OutLargest)
+		{
+			Smallest[j++] = FMath::Clamp(FMath::RoundToInt(Components[i] * Sign * Scale), -MaxValue, MaxValue);
+		}
+	}
+	OutComponents = FIntVector(Smallest[0], Smallest[1], Smallest[2]);
+}
+
+FQuat FSmallestThreeQuat::Dequantize(const FIntVector& Components, int32 Largest, int32 Bits)
+{
+	const int32 MaxValue = (1 << (Bits - 1)) - 1;
+	const float Scale = HALF_SQRT_2 / MaxValue;
+	const float Smallest[3] = { Components.X * Scale, Components.Y * Scale, Components.Z * Scale };
+	const float LargestValue = FMath::Sqrt(FMath::Max(0.0f, 1.0f - Smallest[0] * Smallest[0] - Smallest[1] * Smallest[1] - Smallest[2] * Smallest[2]));
+
+	float Result[4];
+	for (int32 i = 0, j = 0; i < 4; ++i)
+	{
+		Result[i] = i == (Largest & 3) ? LargestValue : Smallest[j++];
+	}
+	return FQuat(Result[0], Result[1], Result[2], Result[3]).GetNormalized();
+}
+
+void FSmallestThreeQuat::Serialize(FArchive& Ar, FQuat& Quat, int32 Bits)
+{
+	const int32 Offset = 1 << (Bits - 1);
+	uint32 Encoded[3] = { 0, 0, 0 };
+	uint32 EncodedLargest = 0;
+	if (Ar.IsSaving())
+	{
+		FIntVector Components;
+		int32 Largest = 0;
+		Quantize(Quat, Bits, Components, Largest);
+		Encoded[0] = static_cast<uint32>(Components.X + Offset);
+		Encoded[1] = static_cast<uint32>(Components.Y + Offset);
+		Encoded[2] = static_cast<uint32>(Components.Z + Offset);
+		EncodedLargest = static_cast<uint32>(Largest);
+	}
+
+	Ar.SerializeBits(&EncodedLargest, 2);
+	for (uint32& Component : Encoded)
+	{
+		Ar.SerializeBits(&Component, Bits);
+	}
+
+	if (Ar.IsLoading())
+	{
+		const FIntVector Components(static_cast<int32>(Encoded[0]) - Offset, static_cast<int32>(Encoded[1]) - Offset, static_cast<int32>(Encoded[2]) - Offset);
+		Quat = Dequantize(Components, static_cast<int32>(EncodedLargest), Bits);
+	}
+}
+
+FQuantizedMotionSnapshot FQuantizedMotionSnapshot::Quantize(const FMotionSnapshot& Snapshot, const FMotionSnapshotPrecision& Precision)
+{
+	FQuantizedMotionSnapshot Result;
+	Result.Location = QuantizeVector(Snapshot.Location, Precision.Location);
+	FSmallestThreeQuat::Quantize(Snapshot.Rotation.Quaternion(), FMath::Clamp(Precision.RotationBits, 4, 20), Result.Rotation, Result.RotationLargest);
+	Result.Velocity = QuantizeVector(Snapshot.Velocity, Precision.Velocity);
+	Result.AngularVelocity = QuantizeVector(Snapshot.AngularVelocity, Precision.AngularVelocity);
+	Result.Timestamp = static_cast<int32>(FMath::RoundToDouble(Snapshot.Timestamp * MotionTimestampScale));
+
+	Result.Transforms.SetNum(FMath::Min(Snapshot.Transforms.Num(), MaxMotionSyncTargets));
+	for (int32 i = 0; i < Result.Transforms.Num(); ++i)
+	{
+		const FMotionTransformPrecision& TransformPrecision = Precision.GetTransformPrecision(i);
+		FQuantizedMotionTransform& Transform = Result.Transforms[i];
+		Transform.Location = QuantizeVector(Snapshot.Transforms[i].Location, TransformPrecision.Location);
+		FSmallestThreeQuat::Quantize(Snapshot.Transforms[i].Rotation, GetRotationComponentBits(TransformPrecision.RotationBits), Transform.Rotation, Transform.RotationLargest);
+	}
+
+	// chained from the snapshot back to the oldest sample, the oldest ones are dropped past the limit
+	Result.Samples.SetNum(FMath::Min(Snapshot.Samples.Num(), MaxMotionSnapshotSamples));
+	const int32 FirstSample = Snapshot.Samples.Num() - Result.Samples.Num();
+	FIntVector ReferenceLocation = Result.Location;
+	FIntVector ReferenceRotation = Result.Rotation;
+	int32 ReferenceLargest = Result.RotationLargest;
+	int32 ReferenceTimestamp = Result.Timestamp;
+	TArray<FQuantizedMotionTransform> ReferenceTransforms = Result.Transforms;
+	for (int32 i = Result.Samples.Num() - 1; i >= 0; --i)
+	{
+		const FMotionSnapshotSample& Sample = Snapshot.Samples[FirstSample + i];
+		const FIntVector SampleLocation = QuantizeVector(Sample.Location, Precision.Location);
+		FIntVector SampleRotation;
+		int32 SampleLargest = 3;
+		FSmallestThreeQuat::Quantize(Sample.Rotation.Quaternion(), GetRotationComponentBits(Precision.RotationBits), SampleRotation, SampleLargest);
+		const int32 SampleTimestamp = static_cast<int32>(FMath::RoundToDouble(Sample.Timestamp * MotionTimestampScale));
+
+		FQuantizedMotionSample& Quantized = Result.Samples[i];
+		Quantized.Location = SampleLocation - ReferenceLocation;
+		Quantized.RotationLargest = SampleLargest;
+		Quantized.Rotation = SampleLargest == ReferenceLargest ? SampleRotation - ReferenceRotation : SampleRotation;
+		Quantized.Age = ReferenceTimestamp - SampleTimestamp;
+
+		// as many as the snapshot has, so the receiver knows the count
+		Quantized.Transforms.SetNum(ReferenceTransforms.Num());
+		for (int32 j = 0; j < ReferenceTransforms.Num(); ++j)
+		{
+			const FMotionTransformPrecision& TransformPrecision = Precision.GetTransformPrecision(j);
+			const FMotionSnapshotTransform SampleTransform = Sample.Transforms.IsValidIndex(j) ? Sample.Transforms[j] : FMotionSnapshotTransform();
+			FQuantizedMotionTransform Transform;
+			Transform.Location = QuantizeVector(SampleTransform.Location, TransformPrecision.Location);
+			FSmallestThreeQuat::Quantize(SampleTransform.Rotation, GetRotationComponentBits(TransformPrecision.RotationBits), Transform.Rotation, Transform.RotationLargest);
+
+			FQuantizedMotionTransform& QuantizedTransform = Quantized.Transforms[j];
+			QuantizedTransform.Location = Transform.Location - ReferenceTransforms[j].Location;
+			QuantizedTransform.RotationLargest = Transform.RotationLargest;
+			QuantizedTransform.Rotation = Transform.RotationLargest == ReferenceTransforms[j].RotationLargest ? Transform.Rotation - ReferenceTransforms[j].Rotation : Transform.Rotation;
+			ReferenceTransforms[j] = Transform;
+		}
+
+		ReferenceLocation = SampleLocation;
+		ReferenceRotation = SampleRotation;
+		ReferenceLargest = SampleLargest;
+		ReferenceTimestamp = SampleTimestamp;
+	}
+	return Result;
+}
+
+FMotionSnapshot FQuantizedMotionSnapshot::Dequantize(const FMotionSnapshotPrecision& Precision) const
+{
+	FMotionSnapshot Result;
+	Result.Location = DequantizeVector(Location, Precision.Location);
+	Result.Rotation = FSmallestThreeQuat::Dequantize(Rotation, RotationLargest, FMath::Clamp(Precision.RotationBits, 4, 20)).Rotator();
+	Result.Velocity = DequantizeVector(Velocity, Precision.Velocity);
+	Result.AngularVelocity = DequantizeVector(AngularVelocity, Precision.AngularVelocity);
+	Result.Timestamp = Timestamp / MotionTimestampScale;
+
+	Result.Transforms.SetNum(Transforms.Num());
+	for (int32 i = 0; i < Transforms.Num(); ++i)
+	{
+		const FMotionTransformPrecision& TransformPrecision = Precision.GetTransformPrecision(i);
+		Result.Transforms[i].Location = DequantizeVector(Transforms[i].Location, TransformPrecision.Location);
+		Result.Transforms[i].Rotation = FSmallestThreeQuat::Dequantize(Transforms[i].Rotation, Transforms[i].RotationLargest, GetRotationComponentBits(TransformPrecision.RotationBits));
+	}
+
+	Result.Samples.SetNum(Samples.Num());
+	FIntVector ReferenceLocation = Location;
+	FIntVector ReferenceRotation = Rotation;
+	int32 ReferenceLargest = RotationLargest;
+	int32 ReferenceTimestamp = Timestamp;
+	TArray<FQuantizedMotionTransform> ReferenceTransforms = Transforms;
+	for (int32 i = Samples.Num() - 1; i >= 0; --i)
+	{
+		const FQuantizedMotionSample& Quantized = Samples[i];
+		ReferenceLocation = ReferenceLocation + Quantized.Location;
+		ReferenceRotation = Quantized.RotationLargest == ReferenceLargest ? ReferenceRotation + Quantized.Rotation : Quantized.Rotation;
+		ReferenceLargest = Quantized.RotationLargest;
+		ReferenceTimestamp = ReferenceTimestamp - Quantized.Age;
+
+		FMotionSnapshotSample& Sample = Result.Samples[i];
+		Sample.Location = DequantizeVector(ReferenceLocation, Precision.Location);
+		Sample.Rotation = FSmallestThreeQuat::Dequantize(ReferenceRotation, ReferenceLargest, GetRotationComponentBits(Precision.RotationBits)).Rotator();
+		Sample.Timestamp = ReferenceTimestamp / MotionTimestampScale;
+
+		Sample.Transforms.SetNum(FMath::Min(Quantized.Transforms.Num(), ReferenceTransforms.Num()));
+		for (int32 j = 0; j < Sample.Transforms.Num(); ++j)
+		{
+			const FQuantizedMotionTransform& QuantizedTransform = Quantized.Transforms[j];
+			FQuantizedMotionTransform& Transform = ReferenceTransforms[j];
+			Transform.Location = Transform.Location + QuantizedTransform.Location;
+			Transform.Rotation = QuantizedTransform.RotationLargest == Transform.RotationLargest ? Transform.Rotation + QuantizedTransform.Rotation : QuantizedTransform.Rotation;
+			Transform.RotationLargest = QuantizedTransform.RotationLargest;
+
+			const FMotionTransformPrecision& TransformPrecision = Precision.GetTransformPrecision(j);
+			Sample.Transforms[j].Location = DequantizeVector(Transform.Location, TransformPrecision.Location);
+			Sample.Transforms[j].Rotation = FSmallestThreeQuat::Dequantize(Transform.Rotation, Transform.RotationLargest, GetRotationComponentBits(TransformPrecision.RotationBits));
+		}
+	}
+	return Result;
+}
+
+FQuantizedMotionSnapshot FQuantizedMotionSnapshot::MakeDelta(const FQuantizedMotionSnapshot& Baseline) const
+{
+	FQuantizedMotionSnapshot Delta;
+	Delta.Location = Location - Baseline.Location;
+	Delta.RotationLargest = RotationLargest;
+	Delta.Rotation = RotationLargest == Baseline.RotationLargest ? Rotation - Baseline.Rotation : Rotation;
+	Delta.Velocity = Velocity - Baseline.Velocity;
+	Delta.AngularVelocity = AngularVelocity - Baseline.AngularVelocity;
+	Delta.Timestamp = Timestamp - Baseline.Timestamp;
+	Delta.Samples = Samples;
+
+	Delta.Transforms = Transforms;
+	if (Transforms.Num() == Baseline.Transforms.Num())
+	{
+		for (int32 i = 0; i < Transforms.Num(); ++i)
+		{
+			const FQuantizedMotionTransform& Base = Baseline.Transforms[i];
+			FQuantizedMotionTransform& Transform = Delta.Transforms[i];
+			Transform.Location = Transforms[i].Location - Base.Location;
+			if (Transform.RotationLargest == Base.RotationLargest)
+			{
+				Transform.Rotation = Transforms[i].Rotation - Base.Rotation;
+			}
+		}
+	}
+	return Delta;
+}
+
+FQuantizedMotionSnapshot FQuantizedMotionSnapshot::ApplyDelta(const FQuantizedMotionSnapshot& Baseline) const
+{
+	FQuantizedMotionSnapshot Result;
+	Result.Location = Baseline.Location + Location;
+	Result.RotationLargest = RotationLargest;
+	Result.Rotation = RotationLargest == Baseline.RotationLargest ? Baseline.Rotation + Rotation : Rotation;
+	Result.Velocity = Baseline.Velocity + Velocity;
+	Result.AngularVelocity = Baseline.AngularVelocity + AngularVelocity;
+	Result.Timestamp = Baseline.Timestamp + Timestamp;
+	Result.Samples = Samples;
+
+	Result.Transforms = Transforms;
+	if (Transforms.Num() == Baseline.Transforms.Num())
+	{
+		for (int32 i = 0; i < Transforms.Num(); ++i)
+		{
+			const FQuantizedMotionTransform& Base = Baseline.Transforms[i];
+			FQuantizedMotionTransform& Transform = Result.Transforms[i];
+			Transform.Location = Base.Location + Transforms[i].Location;
+			if (Transform.RotationLargest == Base.RotationLargest)
+			{
+				Transform.Rotation = Base.Rotation + Transforms[i].Rotation;
+			}
+		}
+	}
+	return Result;
+}
+
+void FQuantizedMotionSnapshot::Serialize(FArchive& Ar)
+{
+	SerializeQuantizedVector(Ar, Location);
+	uint32 Largest = Ar.IsSaving() ? static_cast<uint32>(RotationLargest) : 0;
+	Ar.SerializeBits(&Largest, 2);
+	RotationLargest = static_cast<int32>(Largest & 3);
+	SerializeQuantizedVector(Ar, Rotation);
+	SerializeQuantizedVector(Ar, Velocity);
+	SerializeQuantizedVector(Ar, AngularVelocity);
+	SerializePackedInts(Ar, &Timestamp, 1);
+
+	int32 NumTransforms = Transforms.Num();
+	SerializePackedInts(Ar, &NumTransforms, 1);
+	if (NumTransforms < 0 || NumTransforms > MaxMotionSyncTargets)
+	{
+		Ar.SetError();
+		return;
+	}
+	if (Ar.IsLoading())
+	{
+		Transforms.SetNum(NumTransforms);
+	}
+	for (FQuantizedMotionTransform& Transform : Transforms)
+	{
+		SerializeQuantizedVector(Ar, Transform.Location);
+		uint32 TransformLargest = Ar.IsSaving() ? static_cast<uint32>(Transform.RotationLargest) : 0;
+		Ar.SerializeBits(&TransformLargest, 2);
+		Transform.RotationLargest = static_cast<int32>(TransformLargest & 3);
+		SerializeQuantizedVector(Ar, Transform.Rotation);
+	}
+
+	int32 NumSamples = Samples.Num();
+	SerializePackedInts(Ar, &NumSamples, 1);
+	if (NumSamples < 0 || NumSamples > MaxMotionSnapshotSamples)
+	{
+		Ar.SetError();
+		return;
+	}
+	if (Ar.IsLoading())
+	{
+		Samples.SetNum(NumSamples);
+	}
+	for (FQuantizedMotionSample& Sample : Samples)
+	{
+		SerializeQuantizedVector(Ar, Sample.Location);
+		uint32 SampleLargest = Ar.IsSaving() ? static_cast<uint32>(Sample.RotationLargest) : 0;
+		Ar.SerializeBits(&SampleLargest, 2);
+		Sample.RotationLargest = static_cast<int32>(SampleLargest & 3);
+		SerializeQuantizedVector(Ar, Sample.Rotation);
+		SerializePackedInts(Ar, &Sample.Age, 1);
+
+		// one per sync target of the snapshot, the count isn't sent again
+		Sample.Transforms.SetNum(NumTransforms);
+		for (FQuantizedMotionTransform& Transform : Sample.Transforms)
+		{
+			SerializeQuantizedVector(Ar, Transform.Location);
+			uint32 TransformLargest = Ar.IsSaving() ? static_cast<uint32>(Transform.RotationLargest) : 0;
+			Ar.SerializeBits(&TransformLargest, 2);
+			Transform.RotationLargest = static_cast<int32>(TransformLargest & 3);
+			SerializeQuantizedVector(Ar, Transform.Rotation);
+		}
+	}
+}
@@ -0,0 +1,174 @@
+#include "MotionSnapshotRecording.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "PunchBagOnline.h"
+
+FMotionSnapshotRecord FMotionSnapshotRecord::Make(uint32 StreamId, EMotionSnapshotRecordKind Kind, const FMotionSnapshot& Snapshot)
+{
+	FMotionSnapshotRecord Record;
+	Record.StreamId = StreamId;
+	Record.Kind = static_cast<uint8>(Kind);
+	Record.Timestamp = Snapshot.Timestamp;
+	Record.ArrivalTime = Snapshot.ArrivalTime;
+	for (int32 i = 0; i < 3; ++i)
+	{
+		Record.Location[i] = Snapshot.Location[i];
+		Record.Velocity[i] = Snapshot.Velocity[i];
+		Record.AngularVelocity[i] = Snapshot.AngularVelocity[i];
+	}
+	Record.Rotation[0] = Snapshot.Rotation.Pitch;
+	Record.Rotation[1] = Snapshot.Rotation.Yaw;
+	Record.Rotation[2] = Snapshot.Rotation.Roll;
+	return Record;
+}
+
+FMotionSnapshot FMotionSnapshotRecord::ToSnapshot() const
+{
+	FMotionSnapshot Snapshot;
+	Snapshot.Location = FVector(Location[0], Location[1], Location[2]);
+	Snapshot.Rotation = FRotator(Rotation[0], Rotation[1], Rotation[2]);
+	Snapshot.Velocity = FVector(Velocity[0], Velocity[1], Velocity[2]);
+	Snapshot.AngularVelocity = FVector(AngularVelocity[0], AngularVelocity[1], AngularVelocity[2]);
+	Snapshot.Timestamp = Timestamp;
+	Snapshot.ArrivalTime = ArrivalTime;
+	return Snapshot;
+}
+
+FMotionSnapshotRecorder::~FMotionSnapshotRecorder()
+{
+	Close();
+}
+
+bool FMotionSnapshotRecorder::Open(const FString& InFilename)
+{
+	Close();
+
+	const int64 ExistingSize = IFileManager::Get().FileSize(*InFilename);
+	if (ExistingSize > 0)
+	{
+		// only append whole records to a valid recording
+		FMotionSnapshotRecordingHeader Header;
+		const TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*InFilename));
+		if (!Reader.IsValid() || ExistingSize < static_cast<int64>(sizeof(Header)))
+		{
+			return false;
+		}
+		Reader->Serialize(&Header, sizeof(Header));
+		if (!Header.IsValid() || (ExistingSize - sizeof(Header)) % sizeof(FMotionSnapshotRecord) != 0)
+		{
+			UE_LOG(LogMotionInterpolator, Warning, TEXT("%s is not a snapshot recording or has a torn record, not appending to it"), *InFilename);
+			return false;
+		}
+		NumRecords = (ExistingSize - sizeof(Header)) / sizeof(FMotionSnapshotRecord);
+	}
+
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*InFilename, FILEWRITE_Append | FILEWRITE_AllowRead));
+	if (!Writer.IsValid())
+	{
+		return false;
+	}
+	if (ExistingSize <= 0)
+	{
+		FMotionSnapshotRecordingHeader Header;
+		Writer->Serialize(&Header, sizeof(Header));
+		NumRecords = 0;
+	}
+	Filename = InFilename;
+	// the clock of this session starts over, readers mustn't mix its times with the previous ones
+	BeginSession();
+	return true;
+}
+
+void FMotionSnapshotRecorder::BeginSession()
+{
+	Record(0, EMotionSnapshotRecordKind::Session, FMotionSnapshot());
+}
+
+void FMotionSnapshotRecorder::Close()
+{
+	if (Writer.IsValid())
+	{
+		Writer->Close();
+		Writer.Reset();
+	}
+}
+
+void FMotionSnapshotRecorder::Record(uint32 StreamId, EMotionSnapshotRecordKind Kind, const FMotionSnapshot& Snapshot)
+{
+	if (Writer.IsValid())
+	{
+		FMotionSnapshotRecord Record = FMotionSnapshotRecord::Make(StreamId, Kind, Snapshot);
+		Writer->Serialize(&Record, sizeof(Record));
+		++NumRecords;
+	}
+}
+
+uint32 FMotionSnapshotRecorder::GetStreamId(const UMotionInterpolatorComponent& Interpolator)
+{
+	return FCrc::StrCrc32(*Interpolator.GetPathName());
+}
+
+FMotionSnapshotRecordingReader::~FMotionSnapshotRecordingReader()
+{
+	// the region has to go before its file
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FMotionSnapshotRecordingReader::Open(const FString& Filename)
+{
+	Records = TArrayView<const FMotionSnapshotRecord>();
+	Sessions.Reset();
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedData.Empty();
+
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+		if (MappedRegion.IsValid())
+		{
+			Data = MappedRegion->GetMappedPtr();
+			Size = MappedRegion->GetMappedSize();
+		}
+	}
+	if (Data == nullptr)
+	{
+		if (!FFileHelper::LoadFileToArray(LoadedData, *Filename))
+		{
+			return false;
+		}
+		Data = LoadedData.GetData();
+		Size = LoadedData.Num();
+	}
+
+	if (Size < static_cast<int64>(sizeof(FMotionSnapshotRecordingHeader)) || !reinterpret_cast<const FMotionSnapshotRecordingHeader*>(Data)->IsValid())
+	{
+		UE_LOG(LogMotionInterpolator, Warning, TEXT("%s is not a snapshot recording"), *Filename);
+		return false;
+	}
+
+	// a torn last record of a crashed session is ignored
+	const int64 NumRecords = (Size - sizeof(FMotionSnapshotRecordingHeader)) / sizeof(FMotionSnapshotRecord);
+	Records = TArrayView<const FMotionSnapshotRecord>(reinterpret_cast<const FMotionSnapshotRecord*>(Data + sizeof(FMotionSnapshotRecordingHeader)), static_cast<int32>(NumRecords));
+
+	int32 SessionStart = 0;
+	for (int32 i = 0; i <= Records.Num(); ++i)
+	{
+		if (i == Records.Num() || Records[i].GetKind() == EMotionSnapshotRecordKind::Session)
+		{
+			if (i > SessionStart)
+			{
+				Sessions.Add(Records.Slice(SessionStart, i - SessionStart));
+			}
+			SessionStart = i + 1;
+		}
+	}
+	return true;
+}
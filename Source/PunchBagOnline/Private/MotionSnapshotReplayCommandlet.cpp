@@ -0,0 +1,272 @@
+#include "MotionSnapshotReplayCommandlet.h"
+#include "MotionInterpolatorComponent.h"
+#include "MotionInterpolatorSubsystem.h"
+#include "MotionSnapshotRecording.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "PunchBagOnline.h"
+
+namespace MotionSnapshotReplay
+{
+	struct FReplayStream
+	{
+		uint32 StreamId = 0;
+		UMotionInterpolatorComponent* Interpolator = nullptr;
+		USceneComponent* Root = nullptr;
+	};
+
+	struct FReplaySettings
+	{
+		double TickRate = 60.0;
+		EMotionInterpolationMode InterpolationMode = EMotionInterpolationMode::PredictionBlend;
+		bool bUseExtrapolation = false;
+	};
+
+	/**
+	 * Replays the received records of one session into fresh interpolators of their own world, appending the applied states to Output.
+	 * Returns the number of replayed streams, 0 if the session has nothing to replay.
+	 */
+	static int32 ReplaySession(TArrayView<const FMotionSnapshotRecord> Records, const FReplaySettings& Settings, FMotionSnapshotRecorder& Output, uint32& InOutCrc, double& OutDuration)
+	{
+		double StartTime = MAX_dbl;
+		double EndTime = -MAX_dbl;
+		TArray<uint32> StreamIds;
+		for (const FMotionSnapshotRecord& Record : Records)
+		{
+			if (Record.GetKind() == EMotionSnapshotRecordKind::Received)
+			{
+				StartTime = FMath::Min<double>(StartTime, Record.ArrivalTime);
+				EndTime = FMath::Max<double>(EndTime, Record.ArrivalTime);
+				StreamIds.AddUnique(Record.StreamId);
+			}
+		}
+		OutDuration = 0.0;
+		if (StreamIds.Num() == 0)
+		{
+			return 0;
+		}
+
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("MotionSnapshotReplay"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		const FURL URL;
+		World->SetGameMode(URL);
+		World->InitializeActorsForPlay(URL);
+		World->BeginPlay();
+
+		UMotionInterpolatorSubsystem* Subsystem = World->GetSubsystem<UMotionInterpolatorSubsystem>();
+		check(IsValid(Subsystem));
+		Subsystem->SetManualClockTime(StartTime);
+
+		// simulated proxies only interpolate what they receive
+		TMap<uint32, FReplayStream> Streams;
+		for (uint32 StreamId : StreamIds)
+		{
+			FReplayStream& Stream = Streams.Add(StreamId);
+			Stream.StreamId = StreamId;
+
+			AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity);
+			Actor->SetRole(ROLE_SimulatedProxy);
+
+			Stream.Root = NewObject<USceneComponent>(Actor, TEXT("Root"));
+			Stream.Root->SetMobility(EComponentMobility::Movable);
+			Actor->SetRootComponent(Stream.Root);
+			Stream.Root->RegisterComponent();
+
+			Stream.Interpolator = NewObject<UMotionInterpolatorComponent>(Actor, TEXT("MotionInterpolator"));
+			Stream.Interpolator->SnapPeriod = 0.0f;
+			Stream.Interpolator->InterpolationMode = Settings.InterpolationMode;
+			Stream.Interpolator->UseExtrapolation = Settings.bUseExtrapolation;
+			Stream.Interpolator->RegisterComponent();
+		}
+
+		// keep going a little past the last arrival so the buffers play out
+		const double DeltaTime = 1.0 / Settings.TickRate;
+		const double PlayoutTime = 2.0;
+		const int64 NumSteps = FMath::CeilToInt((EndTime - StartTime + PlayoutTime) / DeltaTime);
+		int32 Cursor = 0;
+		for (int64 Step = 0; Step <= NumSteps; ++Step)
+		{
+			const double Time = StartTime + Step * DeltaTime;
+			Subsystem->SetManualClockTime(Time);
+			++GFrameCounter;
+
+			// records of a session are in the order they were added, which is arrival order
+			for (; Cursor < Records.Num() && Records[Cursor].ArrivalTime <= Time; ++Cursor)
+			{
+				const FMotionSnapshotRecord& Record = Records[Cursor];
+				if (Record.GetKind() == EMotionSnapshotRecordKind::Received)
+				{
+					Streams.FindChecked(Record.StreamId).Interpolator->ReceiveSnapshot(Record.ToSnapshot());
+				}
+			}
+
+			Subsystem->TickInterpolators(static_cast<float>(DeltaTime));
+
+			for (uint32 StreamId : StreamIds)
+			{
+				const FReplayStream& Stream = Streams.FindChecked(StreamId);
+				FMotionSnapshot Applied(*Stream.Root, Stream.Interpolator->GetLookupTime());
+				Applied.ArrivalTime = Time;
+				Output.Record(StreamId, EMotionSnapshotRecordKind::Applied, Applied);
+
+				const FMotionSnapshotRecord Record = FMotionSnapshotRecord::Make(StreamId, EMotionSnapshotRecordKind::Applied, Applied);
+				InOutCrc = FCrc::MemCrc32(&Record, sizeof(Record), InOutCrc);
+			}
+		}
+
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+
+		OutDuration = EndTime - StartTime;
+		return StreamIds.Num();
+	}
+
+	/** Largest location and rotation difference of two replay outputs */
+	static bool CompareOutputs(TArrayView<const FMotionSnapshotRecord> Output, TArrayView<const FMotionSnapshotRecord> Reference, float& OutMaxLocationError, float& OutMaxRotationError)
+	{
+		OutMaxLocationError = 0.0f;
+		OutMaxRotationError = 0.0f;
+		if (Output.Num() != Reference.Num())
+		{
+			return false;
+		}
+		for (int32 i = 0; i < Output.Num(); ++i)
+		{
+			if (Output[i].StreamId != Reference[i].StreamId)
+			{
+				return false;
+			}
+			const FMotionSnapshot A = Output[i].ToSnapshot();
+			const FMotionSnapshot B = Reference[i].ToSnapshot();
+			OutMaxLocationError = FMath::Max(OutMaxLocationError, FVector::Dist(A.Location, B.Location));
+			OutMaxRotationError = FMath::Max(OutMaxRotationError, FMath::RadiansToDegrees(A.Rotation.Quaternion().AngularDistance(B.Rotation.Quaternion())));
+		}
+		return true;
+	}
+}
+
+UMotionSnapshotReplayCommandlet::UMotionSnapshotReplayCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UMotionSnapshotReplayCommandlet::Main(const FString& Params)
+{
+	using namespace MotionSnapshotReplay;
+
+	FString InputPath;
+	if (!FParse::Value(*Params, TEXT("Input="), InputPath))
+	{
+		UE_LOG(LogMotionInterpolator, Error, TEXT("Missing -Input=<recording>"));
+		return 1;
+	}
+	FString OutputPath = FPaths::ChangeExtension(InputPath, TEXT("")) + TEXT(".replay.msr");
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	FReplaySettings Settings;
+	float TickRate = 60.0f;
+	FParse::Value(*Params, TEXT("TickRate="), TickRate);
+	Settings.TickRate = FMath::Max(TickRate, 1.0f);
+
+	FString ModeName;
+	if (FParse::Value(*Params, TEXT("Interpolation="), ModeName))
+	{
+		const int64 Mode = StaticEnum<EMotionInterpolationMode>()->GetValueByNameString(ModeName);
+		if (Mode != INDEX_NONE)
+		{
+			Settings.InterpolationMode = static_cast<EMotionInterpolationMode>(Mode);
+		}
+	}
+	Settings.bUseExtrapolation = FParse::Param(*Params, TEXT("UseExtrapolation"));
+
+	FMotionSnapshotRecordingReader Reader;
+	if (!Reader.Open(InputPath))
+	{
+		UE_LOG(LogMotionInterpolator, Error, TEXT("Failed to open recording %s"), *InputPath);
+		return 1;
+	}
+	const TArray<TArrayView<const FMotionSnapshotRecord>>& Sessions = Reader.GetSessions();
+
+	int32 FirstSession = 0;
+	int32 LastSession = Sessions.Num() - 1;
+	int32 SessionIndex = INDEX_NONE;
+	if (FParse::Value(*Params, TEXT("Session="), SessionIndex))
+	{
+		if (!Sessions.IsValidIndex(SessionIndex))
+		{
+			UE_LOG(LogMotionInterpolator, Error, TEXT("%s has %d sessions, there is no session %d"), *InputPath, Sessions.Num(), SessionIndex);
+			return 1;
+		}
+		FirstSession = SessionIndex;
+		LastSession = SessionIndex;
+	}
+
+	IFileManager::Get().Delete(*OutputPath, false, true, true);
+	FMotionSnapshotRecorder Output;
+	if (!Output.Open(OutputPath))
+	{
+		UE_LOG(LogMotionInterpolator, Error, TEXT("Failed to write replay output %s"), *OutputPath);
+		return 1;
+	}
+
+	// sessions restart the clock, each one is replayed on its own and starts a session of the output
+	const double RealStartTime = FPlatformTime::Seconds();
+	uint32 OutputCrc = 0;
+	int32 NumRecords = 0;
+	int32 NumStreams = 0;
+	double SessionsDuration = 0.0;
+	for (int32 i = FirstSession; i <= LastSession; ++i)
+	{
+		if (NumStreams > 0)
+		{
+			Output.BeginSession();
+		}
+		double Duration = 0.0;
+		const int32 NumSessionStreams = ReplaySession(Sessions[i], Settings, Output, OutputCrc, Duration);
+		NumRecords += Sessions[i].Num();
+		NumStreams += NumSessionStreams;
+		SessionsDuration += Duration;
+	}
+	Output.Close();
+
+	if (NumStreams == 0)
+	{
+		UE_LOG(LogMotionInterpolator, Error, TEXT("%s has no received snapshots to replay"), *InputPath);
+		return 1;
+	}
+
+	UE_LOG(LogMotionInterpolator, Display, TEXT("Replayed %d records of %d streams in %d sessions, %.1f s of sessions in %.2f s, output crc %08X written to %s"),
+		NumRecords, NumStreams, LastSession - FirstSession + 1, SessionsDuration, FPlatformTime::Seconds() - RealStartTime, OutputCrc, *OutputPath);
+
+	FString ReferencePath;
+	if (FParse::Value(*Params, TEXT("Reference="), ReferencePath))
+	{
+		float Tolerance = 0.01f;
+		FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+
+		FMotionSnapshotRecordingReader OutputReader;
+		FMotionSnapshotRecordingReader ReferenceReader;
+		float MaxLocationError = 0.0f;
+		float MaxRotationError = 0.0f;
+		if (!OutputReader.Open(OutputPath) || !ReferenceReader.Open(ReferencePath)
+			|| !CompareOutputs(OutputReader.GetRecords(), ReferenceReader.GetRecords(), MaxLocationError, MaxRotationError))
+		{
+			UE_LOG(LogMotionInterpolator, Error, TEXT("%s doesn't replay the same streams and steps as %s"), *OutputPath, *ReferencePath);
+			return 2;
+		}
+		UE_LOG(LogMotionInterpolator, Display, TEXT("Difference to %s: location %.4f, rotation %.4f deg"), *ReferencePath, MaxLocationError, MaxRotationError);
+		if (MaxLocationError > Tolerance || MaxRotationError > Tolerance)
+		{
+			return 2;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,600 @@
+#include "MotionSyncChannelComponent.h"
+#include "MotionInterpolatorSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/NetConnection.h"
+#include "Serialization/BitWriter.h"
+#include "MotionInterpolatorStats.h"
+
+static constexpr int32 MaxSnapshotBatchEntries = 255;
+
+void FMotionSnapshotBatchEntry::Serialize(FArchive& Ar)
+{
+	uint32 PackedNetId = NetId;
+	Ar.SerializeIntPacked(PackedNetId);
+	NetId = static_cast<uint16>(PackedNetId);
+	Ar << Sequence;
+
+	uint8 bIsDelta = IsDelta() ? 1 : 0;
+	Ar.SerializeBits(&bIsDelta, 1);
+	if (bIsDelta)
+	{
+		uint32 BaselineOffset = static_cast<uint16>(Sequence - BaselineSequence);
+		Ar.SerializeInt(BaselineOffset, MotionSnapshotStreamHistory);
+		if (BaselineOffset == 0)
+		{
+			Ar.SetError();
+			return;
+		}
+		BaselineSequence = Sequence - static_cast<uint16>(BaselineOffset);
+	}
+	else
+	{
+		BaselineSequence = Sequence;
+	}
+
+	uint8 bHasAuthorityEpoch = AuthorityEpoch != 0 ? 1 : 0;
+	Ar.SerializeBits(&bHasAuthorityEpoch, 1);
+	if (bHasAuthorityEpoch)
+	{
+		Ar << AuthorityEpoch;
+	}
+	else
+	{
+		AuthorityEpoch = 0;
+	}
+
+	Payload.Serialize(Ar);
+}
+
+void FMotionSnapshotSendStream::Encode(uint16 NetId, const FQuantizedMotionSnapshot& Quantized, uint16 AuthorityEpoch, bool bUseDelta, FMotionSnapshotBatchEntry& OutEntry)
+{
+	OutEntry.NetId = NetId;
+	OutEntry.Sequence = NextSequence++;
+	OutEntry.AuthorityEpoch = AuthorityEpoch;
+
+	const int32 Slot = OutEntry.Sequence % MotionSnapshotStreamHistory;
+	HistorySequences[Slot] = OutEntry.Sequence;
+	History[Slot] = Quantized;
+	// baselines only need the pose
+	History[Slot].Samples.Empty();
+
+	// the receiver keeps the same history window, so anything older may be gone there
+	const uint16 BaselineAge = OutEntry.Sequence - AckedSequence;
+	if (bUseDelta && bHasAckedBaseline && BaselineAge > 0 && BaselineAge < MotionSnapshotStreamHistory)
+	{
+		OutEntry.BaselineSequence = AckedSequence;
+		OutEntry.Payload = Quantized.MakeDelta(AckedBaseline);
+	}
+	else
+	{
+		OutEntry.BaselineSequence = OutEntry.Sequence;
+		OutEntry.Payload = Quantized;
+	}
+}
+
+void FMotionSnapshotSendStream::Ack(uint16 Sequence)
+{
+	const int32 Slot = Sequence % MotionSnapshotStreamHistory;
+	if (HistorySequences[Slot] == Sequence && (!bHasAckedBaseline || IsMotionSequenceNewer(Sequence, AckedSequence)))
+	{
+		bHasAckedBaseline = true;
+		AckedSequence = Sequence;
+		AckedBaseline = History[Slot];
+	}
+}
+
+bool FMotionSnapshotReceiveStream::Decode(const FMotionSnapshotBatchEntry& Entry, FQuantizedMotionSnapshot& OutQuantized, bool& bOutIsLatest)
+{
+	bOutIsLatest = false;
+	OutQuantized = Entry.Payload;
+	if (Entry.IsDelta())
+	{
+		const int32 BaselineSlot = Entry.BaselineSequence % MotionSnapshotStreamHistory;
+		if (!HistoryValid[BaselineSlot] || HistorySequences[BaselineSlot] != Entry.BaselineSequence)
+		{
+			return false;
+		}
+		OutQuantized = Entry.Payload.ApplyDelta(History[BaselineSlot]);
+	}
+
+	const int32 Slot = Entry.Sequence % MotionSnapshotStreamHistory;
+	HistoryValid[Slot] = true;
+	HistorySequences[Slot] = Entry.Sequence;
+	History[Slot] = OutQuantized;
+	History[Slot].Samples.Empty();
+
+	if (!bHasLatest || IsMotionSequenceNewer(Entry.Sequence, LatestSequence))
+	{
+		bHasLatest = true;
+		LatestSequence = Entry.Sequence;
+		bOutIsLatest = true;
+	}
+	return true;
+}
+
+bool FMotionSnapshotBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint32 NumEntries = Entries.Num();
+	uint32 NumAcks = Acks.Num();
+	Ar.SerializeIntPacked(NumEntries);
+	Ar.SerializeIntPacked(NumAcks);
+	if (Ar.IsLoading())
+	{
+		if (NumEntries > static_cast<uint32>(MaxSnapshotBatchEntries) || NumAcks > static_cast<uint32>(MaxSnapshotBatchEntries))
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+		Entries.SetNum(NumEntries);
+		Acks.SetNum(NumAcks);
+	}
+
+	for (FMotionSnapshotBatchEntry& Entry : Entries)
+	{
+		Entry.Serialize(Ar);
+		if (Ar.IsError())
+		{
+			break;
+		}
+	}
+
+	for (FMotionSnapshotAck& Ack : Acks)
+	{
+		uint32 NetId = Ack.NetId;
+		Ar.SerializeIntPacked(NetId);
+		Ack.NetId = static_cast<uint16>(NetId);
+		Ar << Ack.Sequence;
+	}
+
+	if (Ar.IsLoading())
+	{
+		ArrivalTime = UMotionInterpolatorSubsystem::GetPacketArrivalTime(Map);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return bOutSuccess;
+}
+
+UMotionSyncChannelComponent::UMotionSyncChannelComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	// flush after every interpolator has queued its snapshots for this frame
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+	bAutoActivate = true;
+	SetIsReplicatedByDefault(true);
+}
+
+void UMotionSyncChannelComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (IsValid(Subsystem))
+	{
+		Subsystem->RegisterChannel(this);
+	}
+}
+
+void UMotionSyncChannelComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (IsValid(Subsystem))
+	{
+		Subsystem->UnregisterChannel(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UMotionSyncChannelComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	UpdateClockSync(DeltaTime);
+	FlushPendingSnapshots(DeltaTime);
+}
+
+void UMotionSyncChannelComponent::UpdateClockSync(float DeltaTime)
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (!IsLocalChannel() || !IsValid(Subsystem) || Subsystem->IsClockAuthority())
+	{
+		return;
+	}
+
+	ClockSyncTimer -= DeltaTime;
+	if (ClockSyncTimer <= 0.0f)
+	{
+		const bool bIsFilterFilled = Subsystem->GetClockSync().GetNumSamples() >= FMotionClockSync::FilterSize;
+		ClockSyncTimer = bIsFilterFilled ? ClockSyncInterval : InitialClockSyncInterval;
+		ServerRequestClockSync(Subsystem->GetLocalClockTime());
+	}
+}
+
+void UMotionSyncChannelComponent::ServerReceiveImpact_Implementation(uint16 NetId, const FMotionImpactEvent& Impact)
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	UMotionInterpolatorComponent* Interpolator = IsValid(Subsystem) ? Subsystem->FindInterpolatorByNetId(NetId) : nullptr;
+	if (IsValid(Interpolator))
+	{
+		Interpolator->ReceiveImpact(Impact, this);
+	}
+}
+
+void UMotionSyncChannelComponent::ClientReceiveImpact_Implementation(uint16 NetId, const FMotionImpactEvent& Impact)
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	UMotionInterpolatorComponent* Interpolator = IsValid(Subsystem) ? Subsystem->FindInterpolatorByNetId(NetId) : nullptr;
+	if (IsValid(Interpolator))
+	{
+		Interpolator->ReceiveImpact(Impact, this);
+	}
+}
+
+void UMotionSyncChannelComponent::ServerRequestClockSync_Implementation(double ClientSendTime)
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (IsValid(Subsystem))
+	{
+		// uncached, the frame time may be a whole frame old
+		ClientReceiveClockSync(ClientSendTime, Subsystem->GetLocalClockTime());
+	}
+}
+
+void UMotionSyncChannelComponent::ClientReceiveClockSync_Implementation(double ClientSendTime, double ServerTime)
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (IsValid(Subsystem) && !Subsystem->IsClockAuthority())
+	{
+		Subsystem->GetClockSync().AddSample(ClientSendTime, ServerTime, Subsystem->GetLocalClockTime());
+	}
+}
+
+void UMotionSyncChannelComponent::QueueSnapshot(uint16 NetId, const FMotionSnapshot& Snapshot)
+{
+	// only the newest snapshot matters, older unsent ones are replaced
+	FScheduledSnapshot& Scheduled = ScheduledSnapshots.FindOrAdd(NetId);
+	if (!Scheduled.bPending)
+	{
+		Scheduled.bPending = true;
+		++NumPendingSnapshots;
+		Scheduled.Snapshot = Snapshot;
+		return;
+	}
+	if (Scheduled.Snapshot.Timestamp >= Snapshot.Timestamp)
+	{
+		Scheduled.Snapshot = Snapshot;
+		return;
+	}
+
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	const UMotionInterpolatorComponent* Interpolator = IsValid(Subsystem) ? Subsystem->FindInterpolatorByNetId(NetId) : nullptr;
+	const double SampleInterval = IsValid(Interpolator) ? Interpolator->GetSampleInterval() : 0.0;
+	if (SampleInterval <= 0.0 && Snapshot.Samples.Num() == 0)
+	{
+		Scheduled.Snapshot = Snapshot;
+		return;
+	}
+
+	// a sampled stream keeps its arc: senders queue every frame, so the replaced snapshots become the samples of the new one, at most one per SampleInterval
+	TArray<FMotionSnapshotSample> Samples = MoveTemp(Scheduled.Snapshot.Samples);
+	const double LastSampleTime = Samples.Num() > 0 ? Samples.Last().Timestamp : Scheduled.LastSentTimestamp;
+	// samples are encoded against the snapshot's targets
+	if (Scheduled.Snapshot.Timestamp - LastSampleTime >= SampleInterval - KINDA_SMALL_NUMBER && Scheduled.Snapshot.Transforms.Num() == Snapshot.Transforms.Num())
+	{
+		FMotionSnapshotSample& Replaced = Samples.AddDefaulted_GetRef();
+		Replaced.Location = Scheduled.Snapshot.Location;
+		Replaced.Rotation = Scheduled.Snapshot.Rotation;
+		Replaced.Timestamp = Scheduled.Snapshot.Timestamp;
+		Replaced.Transforms = MoveTemp(Scheduled.Snapshot.Transforms);
+	}
+	Samples.Append(Snapshot.Samples);
+	const int32 MaxSamples = IsValid(Interpolator) ? FMath::Clamp(Interpolator->MaxSamplesPerSnapshot, 1, MaxMotionSnapshotSamples) : MaxMotionSnapshotSamples;
+	if (Samples.Num() > MaxSamples)
+	{
+		Samples.RemoveAt(0, Samples.Num() - MaxSamples, false);
+	}
+	Scheduled.Snapshot = Snapshot;
+	Scheduled.Snapshot.Samples = MoveTemp(Samples);
+}
+
+bool UMotionSyncChannelComponent::IsRemoteChannel() const
+{
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	return GetOwnerRole() == ROLE_Authority && IsValid(PlayerController) && !PlayerController->IsLocalController();
+}
+
+bool UMotionSyncChannelComponent::IsLocalChannel() const
+{
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	return GetOwnerRole() != ROLE_Authority && IsValid(PlayerController) && PlayerController->IsLocalController();
+}
+
+UNetConnection* UMotionSyncChannelComponent::GetNetConnection() const
+{
+	const AActor* Owner = GetOwner();
+	return IsValid(Owner) ? Owner->GetNetConnection() : nullptr;
+}
+
+void UMotionSyncChannelComponent::UpdateInterestPoints()
+{
+	InterestPoints.Reset();
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	if (IsValid(PlayerController))
+	{
+		const APawn* Pawn = PlayerController->GetPawn();
+		if (IsValid(Pawn))
+		{
+			InterestPoints.Add(Pawn->GetActorLocation());
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		if (InterestPoints.Num() == 0 || !ViewLocation.Equals(InterestPoints[0]))
+		{
+			InterestPoints.Add(ViewLocation);
+		}
+	}
+}
+
+float UMotionSyncChannelComponent::GetInterestDistance(const FVector& Location) const
+{
+	float MinDistanceSquared = MAX_flt;
+	for (const FVector& InterestPoint : InterestPoints)
+	{
+		MinDistanceSquared = FMath::Min(MinDistanceSquared, FVector::DistSquared(InterestPoint, Location));
+	}
+	return MinDistanceSquared < MAX_flt ? FMath::Sqrt(MinDistanceSquared) : MAX_flt;
+}
+
+void UMotionSyncChannelComponent::ServerReceiveSnapshotBatch_Implementation(const FMotionSnapshotBatch& Batch)
+{
+	ReceiveBatch(Batch);
+}
+
+void UMotionSyncChannelComponent::ClientReceiveSnapshotBatch_Implementation(const FMotionSnapshotBatch& Batch)
+{
+	ReceiveBatch(Batch);
+}
+
+void UMotionSyncChannelComponent::FlushPendingSnapshots(float DeltaTime)
+{
+	const float BitsPerSecond = GetBytesPerSecond() * 8.0f;
+	BudgetBits = FMath::Min(BudgetBits + BitsPerSecond * DeltaTime, BitsPerSecond * FMath::Max(MaxBurstTime, DeltaTime));
+
+	if (NumPendingSnapshots <= 0 && PendingAcks.Num() <= 0)
+	{
+		return;
+	}
+
+	MOTIONINTERP_SCOPE(FlushSnapshots);
+
+	UpdateInterestPoints();
+
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	SendCandidates.Reset();
+	for (auto It = ScheduledSnapshots.CreateIterator(); It; ++It)
+	{
+		FScheduledSnapshot& Scheduled = It.Value();
+		const UMotionInterpolatorComponent* Interpolator = IsValid(Subsystem) ? Subsystem->FindInterpolatorByNetId(It.Key()) : nullptr;
+		if (!IsValid(Interpolator))
+		{
+			if (Scheduled.bPending)
+			{
+				--NumPendingSnapshots;
+			}
+			It.RemoveCurrent();
+			continue;
+		}
+		if (Scheduled.bPending)
+		{
+			Scheduled.Priority += DeltaTime * GetPriorityGain(*Interpolator, Scheduled.Snapshot);
+			if (Scheduled.Priority >= 1.0f)
+			{
+				SendCandidates.Emplace(Scheduled.Priority, It.Key());
+			}
+		}
+	}
+	SendCandidates.Sort([](const TPair<float, uint16>& A, const TPair<float, uint16>& B)
+	{
+		return A.Key > B.Key;
+	});
+
+	const int32 BatchSize = FMath::Clamp<int32>(MaxSnapshotsPerBatch, 1, MaxSnapshotBatchEntries);
+	FMotionSnapshotBatch Batch;
+
+	// acks ride along with the first batch
+	Batch.Acks.Reserve(PendingAcks.Num());
+	for (const TPair<uint16, uint16>& PendingAck : PendingAcks)
+	{
+		if (Batch.Acks.Num() >= MaxSnapshotBatchEntries)
+		{
+			break;
+		}
+		Batch.Acks.Add({ PendingAck.Key, PendingAck.Value });
+	}
+	PendingAcks.Reset();
+
+	// the budget may go into debt by one snapshot, it is paid back the next frames
+	FBitWriter EntryWriter(0, true);
+	int32 NumSentEntries = 0;
+	int32 NumSentBits = 0;
+	for (const TPair<float, uint16>& Candidate : SendCandidates)
+	{
+		if (BudgetBits <= 0.0f)
+		{
+			break;
+		}
+
+		FScheduledSnapshot& Scheduled = ScheduledSnapshots.FindChecked(Candidate.Value);
+		FMotionSnapshotBatchEntry& Entry = Batch.Entries.AddDefaulted_GetRef();
+		EncodeEntry(Candidate.Value, Scheduled.Snapshot, Entry);
+
+		EntryWriter.Reset();
+		Entry.Serialize(EntryWriter);
+		BudgetBits -= EntryWriter.GetNumBits();
+		++NumSentEntries;
+		NumSentBits += static_cast<int32>(EntryWriter.GetNumBits());
+
+		Scheduled.Priority = 0.0f;
+		Scheduled.bPending = false;
+		Scheduled.LastSentTimestamp = Scheduled.Snapshot.Timestamp;
+		--NumPendingSnapshots;
+
+		if (Batch.Entries.Num() >= BatchSize)
+		{
+			SendBatch(Batch);
+			Batch.Entries.Reset();
+			Batch.Acks.Reset();
+		}
+	}
+
+	if (Batch.Entries.Num() > 0 || Batch.Acks.Num() > 0)
+	{
+		SendBatch(Batch);
+	}
+
+	if (IsValid(Subsystem) && NumSentEntries > 0)
+	{
+		Subsystem->RecordSentSnapshots(NumSentEntries, NumSentBits);
+	}
+}
+
+float UMotionSyncChannelComponent::GetPlayoutDelay(uint16 NetId, float SnapshotInterval) const
+{
+	const FMotionJitterEstimator* Estimator = JitterEstimators.Find(NetId);
+	return Estimator != nullptr ? Estimator->GetPlayoutDelay(SnapshotInterval, PlayoutJitterMultiplier) : SnapshotInterval;
+}
+
+float UMotionSyncChannelComponent::GetBytesPerSecond() const
+{
+	float BytesPerSecond = MaxBytesPerSecond;
+	const UNetConnection* Connection = GetNetConnection();
+	if (IsValid(Connection) && Connection->CurrentNetSpeed > 0)
+	{
+		BytesPerSecond = FMath::Min(BytesPerSecond, Connection->CurrentNetSpeed * NetSpeedFraction);
+	}
+	return BytesPerSecond;
+}
+
+float UMotionSyncChannelComponent::GetPriorityGain(const UMotionInterpolatorComponent& Interpolator, const FMotionSnapshot& Snapshot) const
+{
+	// reaches 1 after one sync period for an idle object nearby
+	float Gain = 1.0f / FMath::Max(Interpolator.GetSyncPeriodHint(), KINDA_SMALL_NUMBER);
+
+	Gain *= 1.0f
+		+ Snapshot.Velocity.Size() / FMath::Max(PriorityVelocity, KINDA_SMALL_NUMBER)
+		+ Snapshot.AngularVelocity.Size() / FMath::Max(PriorityAngularVelocity, KINDA_SMALL_NUMBER);
+
+	const float Distance = GetInterestDistance(Snapshot.Location);
+	if (Distance > PriorityDistance && Distance < MAX_flt)
+	{
+		Gain *= FMath::Max(PriorityDistance / Distance, MinDistancePriority);
+	}
+	return Gain;
+}
+
+void UMotionSyncChannelComponent::SendBatch(const FMotionSnapshotBatch& Batch)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		ClientReceiveSnapshotBatch(Batch);
+	}
+	else
+	{
+		ServerReceiveSnapshotBatch(Batch);
+	}
+}
+
+void UMotionSyncChannelComponent::EncodeEntry(uint16 NetId, const FMotionSnapshot& Snapshot, FMotionSnapshotBatchEntry& OutEntry)
+{
+	const FQuantizedMotionSnapshot Quantized = FQuantizedMotionSnapshot::Quantize(Snapshot, GetSnapshotPrecision(NetId));
+	SendStreams.FindOrAdd(NetId).Encode(NetId, Quantized, Snapshot.AuthorityEpoch, bUseDeltaCompression, OutEntry);
+}
+
+bool UMotionSyncChannelComponent::DecodeEntry(const FMotionSnapshotBatchEntry& Entry, FQuantizedMotionSnapshot& OutQuantized)
+{
+	bool bIsLatest = false;
+	if (!ReceiveStreams.FindOrAdd(Entry.NetId).Decode(Entry, OutQuantized, bIsLatest))
+	{
+		return false;
+	}
+	if (bIsLatest)
+	{
+		PendingAcks.Add(Entry.NetId, Entry.Sequence);
+	}
+	return true;
+}
+
+void UMotionSyncChannelComponent::ReceiveBatch(const FMotionSnapshotBatch& Batch)
+{
+	MOTIONINTERP_SCOPE(ReceiveBatch);
+
+	for (const FMotionSnapshotAck& Ack : Batch.Acks)
+	{
+		ProcessAck(Ack);
+	}
+
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	if (!IsValid(Subsystem))
+	{
+		return;
+	}
+
+	FMotionSnapshotDecodeBatch Decoded;
+	Decoded.SourceChannel = this;
+	Decoded.ArrivalTime = Batch.ArrivalTime > 0.0 ? Batch.ArrivalTime : Subsystem->GetSyncedTime();
+	Decoded.Decodes.Reserve(Batch.Entries.Num());
+	for (const FMotionSnapshotBatchEntry& Entry : Batch.Entries)
+	{
+		// the history has to follow every entry, interpolators or not
+		FQuantizedMotionSnapshot Quantized;
+		if (!DecodeEntry(Entry, Quantized))
+		{
+			continue;
+		}
+		UMotionInterpolatorComponent* Interpolator = Subsystem->FindInterpolatorByNetId(Entry.NetId);
+		if (!IsValid(Interpolator))
+		{
+			JitterEstimators.Remove(Entry.NetId);
+			continue;
+		}
+		FMotionSnapshotDecode& Decode = Decoded.Decodes.AddDefaulted_GetRef();
+		Decode.Interpolator = Interpolator;
+		Decode.WeakInterpolator = Interpolator;
+		Decode.Quantized = MoveTemp(Quantized);
+		Decode.Precision = Interpolator->GetSnapshotPrecision();
+		Decode.AuthorityEpoch = Entry.AuthorityEpoch;
+	}
+
+	// snapshots reach their interpolators with the next drain, see UMotionInterpolatorSubsystem::DrainReceivedSnapshots
+	Subsystem->DecodeReceivedSnapshots(MoveTemp(Decoded), LastDecodeTask);
+}
+
+void UMotionSyncChannelComponent::ProcessAck(const FMotionSnapshotAck& Ack)
+{
+	FMotionSnapshotSendStream* Stream = SendStreams.Find(Ack.NetId);
+	if (Stream != nullptr)
+	{
+		Stream->Ack(Ack.Sequence);
+	}
+}
+
+FMotionSnapshotPrecision UMotionSyncChannelComponent::GetSnapshotPrecision(uint16 NetId) const
+{
+	UMotionInterpolatorSubsystem* Subsystem = GetSubsystem();
+	const UMotionInterpolatorComponent* Interpolator = IsValid(Subsystem) ? Subsystem->FindInterpolatorByNetId(NetId) : nullptr;
+	return IsValid(Interpolator) ? Interpolator->GetSnapshotPrecision() : FMotionSnapshotPrecision();
+}
+
+UMotionInterpolatorSubsystem* UMotionSyncChannelComponent::GetSubsystem() const
+{
+	UWorld* World = GetWorld();
+	return IsValid(World) ? World->GetSubsystem<UMotionInterpolatorSubsystem>() : nullptr;
+}
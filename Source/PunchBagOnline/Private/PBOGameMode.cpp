@@ -1,8 +1,22 @@
 #include "PBOGameMode.h"
 #include "PBOGameState.h"
+#include "MotionSyncChannelComponent.h"
+#include "GameFramework/PlayerController.h"
 
 APBOGameMode::APBOGameMode() 
 	: Super()
 {
 	GameStateClass = APBOGameState::StaticClass();
+}
+
+void APBOGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	// every connection gets a channel to batch motion snapshots through
+	if (IsValid(NewPlayer) && !IsValid(NewPlayer->FindComponentByClass<UMotionSyncChannelComponent>()))
+	{
+		UMotionSyncChannelComponent* Channel = NewObject<UMotionSyncChannelComponent>(NewPlayer, TEXT("MotionSyncChannel"));
+		Channel->RegisterComponent();
+	}
 }
\ No newline at end of file
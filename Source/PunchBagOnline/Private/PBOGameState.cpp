@@ -2,6 +2,8 @@
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
 #include "GameFramework/PlayerState.h"
+#include "Net/UnrealNetwork.h"
+#include "MotionInterpolatorSubsystem.h"
 
 float APBOGameState::GetServerWorldTimeSeconds() const
 {
@@ -19,3 +21,37 @@ float APBOGameState::GetServerWorldTimeSeconds() const
 	}
 	return Super::GetServerWorldTimeSeconds() + (PlayerPing*2*0.001);
 }
+
+double APBOGameState::GetSyncedTimeSeconds() const
+{
+	return UMotionInterpolatorSubsystem::GetWorldSyncedTime(GetWorld());
+}
+
+void APBOGameState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// the first server world time update only comes after ServerWorldTimeSecondsUpdateFrequency
+	if (HasAuthority())
+	{
+		UpdateServerTimeSeconds();
+	}
+}
+
+void APBOGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(APBOGameState, SyncedClockOffset);
+}
+
+void APBOGameState::UpdateServerTimeSeconds()
+{
+	Super::UpdateServerTimeSeconds();
+
+	const UWorld* World = GetWorld();
+	if (IsValid(World))
+	{
+		SyncedClockOffset = GetSyncedTimeSeconds() - World->GetTimeSeconds();
+	}
+}
@@ -0,0 +1,256 @@
+#include "PBOReplicationGraph.h"
+#include "MotionInterpolatorComponent.h"
+#include "MotionInterpolatorSubsystem.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
+#include "PunchBagOnline.h"
+
+void UPBOReplicationGraph::ResetGameWorldState()
+{
+	Super::ResetGameWorldState();
+
+	ActorRoutes.Reset();
+	OwnerOnlyActorConnections.Reset();
+	PendingOwnerOnlyActors.Reset();
+}
+
+void UPBOReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	const float ServerTickRate = NetDriver != nullptr ? static_cast<float>(NetDriver->NetServerMaxTickRate) : 30.0f;
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (ActorCDO == nullptr || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+		// skeleton and reinstanced blueprint classes never get spawned
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.SetCullDistanceSquared(ActorCDO->NetCullDistanceSquared);
+		const float UpdateFrequency = FMath::Max(ActorCDO->NetUpdateFrequency, 1.0f);
+		ClassInfo.ReplicationPeriodFrame = static_cast<uint8>(FMath::Clamp(FMath::RoundToInt(ServerTickRate / UpdateFrequency), 1, 255));
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UPBOReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = SpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UPBOReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// the connection's player controller, pawn and view target
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnection = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnection, RepGraphConnection);
+
+	UReplicationGraphNode_ActorList* OwnerOnlyNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddConnectionGraphNode(OwnerOnlyNode, RepGraphConnection);
+	OwnerOnlyNodes.Add(RepGraphConnection->NetConnection, OwnerOnlyNode);
+}
+
+void UPBOReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	OwnerOnlyNodes.Remove(NetConnection);
+
+	// the node goes away with the connection, its actors wait for a new owner
+	for (auto It = OwnerOnlyActorConnections.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Get() == NetConnection || !It.Value().IsValid())
+		{
+			PendingOwnerOnlyActors.Add(It.Key().ResolveObjectPtr());
+			It.RemoveCurrent();
+		}
+	}
+
+	Super::RemoveClientConnection(NetConnection);
+}
+
+int32 UPBOReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	UpdateOwnerOnlyActors();
+
+	return Super::ServerReplicateActors(DeltaSeconds);
+}
+
+bool UPBOReplicationGraph::AddOwnerOnlyActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	UNetConnection* Connection = ActorInfo.Actor->GetNetConnection();
+	UReplicationGraphNode_ActorList** OwnerOnlyNode = Connection != nullptr ? OwnerOnlyNodes.Find(Connection) : nullptr;
+	if (OwnerOnlyNode == nullptr)
+	{
+		return false;
+	}
+
+	(*OwnerOnlyNode)->NotifyAddNetworkActor(ActorInfo);
+	OwnerOnlyActorConnections.Add(ActorInfo.Actor, Connection);
+	return true;
+}
+
+void UPBOReplicationGraph::UpdateOwnerOnlyActors()
+{
+	for (auto It = OwnerOnlyActorConnections.CreateIterator(); It; ++It)
+	{
+		AActor* Actor = It.Key().ResolveObjectPtr();
+		if (Actor == nullptr || Actor->GetNetConnection() == It.Value().Get())
+		{
+			continue;
+		}
+
+		UReplicationGraphNode_ActorList** OwnerOnlyNode = OwnerOnlyNodes.Find(It.Value().Get());
+		if (OwnerOnlyNode != nullptr)
+		{
+			(*OwnerOnlyNode)->NotifyRemoveNetworkActor(FNewReplicatedActorInfo(Actor));
+		}
+		PendingOwnerOnlyActors.Add(Actor);
+		It.RemoveCurrent();
+	}
+
+	for (int32 Index = PendingOwnerOnlyActors.Num() - 1; Index >= 0; --Index)
+	{
+		AActor* Actor = PendingOwnerOnlyActors[Index].Get();
+		if (Actor == nullptr || AddOwnerOnlyActor(FNewReplicatedActorInfo(Actor)))
+		{
+			PendingOwnerOnlyActors.RemoveAtSwap(Index, 1, false);
+		}
+	}
+}
+
+EPBOActorRoute UPBOReplicationGraph::GetActorRoute(const AActor* Actor) const
+{
+	if (Actor->bAlwaysRelevant)
+	{
+		return EPBOActorRoute::RelevantAllConnections;
+	}
+	if (Actor->IsA<APlayerController>())
+	{
+		return EPBOActorRoute::NotRouted;
+	}
+	if (Actor->bOnlyRelevantToOwner)
+	{
+		return EPBOActorRoute::OnlyRelevantToOwner;
+	}
+	if (Actor->IsA<APawn>())
+	{
+		return EPBOActorRoute::Spatialize_Dynamic;
+	}
+	const UMotionInterpolatorComponent* Interpolator = Actor->FindComponentByClass<UMotionInterpolatorComponent>();
+	if (Interpolator != nullptr)
+	{
+		// the grid switches dormancy actors between its static and dynamic lists on every dormancy change
+		const bool bCanBeDormant = Interpolator->bDriveNetDormancy && Actor->NetDormancy != DORM_Never;
+		return bCanBeDormant ? EPBOActorRoute::Spatialize_Dormancy : EPBOActorRoute::Spatialize_Dynamic;
+	}
+	const USceneComponent* Root = Actor->GetRootComponent();
+	if (Root == nullptr)
+	{
+		return EPBOActorRoute::RelevantAllConnections;
+	}
+	return Root->Mobility == EComponentMobility::Movable ? EPBOActorRoute::Spatialize_Dynamic : EPBOActorRoute::Spatialize_Static;
+}
+
+void UPBOReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	AActor* Actor = ActorInfo.Actor;
+	const EPBOActorRoute Route = GetActorRoute(Actor);
+	ActorRoutes.Add(Actor, Route);
+
+	if (Actor->FindComponentByClass<UMotionInterpolatorComponent>() != nullptr)
+	{
+		const UWorld* World = Actor->GetWorld();
+		const UMotionInterpolatorSubsystem* Subsystem = IsValid(World) ? World->GetSubsystem<UMotionInterpolatorSubsystem>() : nullptr;
+		if (IsValid(Subsystem) && Subsystem->bUseInterestManagement)
+		{
+			GlobalInfo.Settings.SetCullDistanceSquared(FMath::Square(Subsystem->InterestRadius));
+		}
+	}
+
+	switch (Route)
+	{
+	case EPBOActorRoute::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case EPBOActorRoute::OnlyRelevantToOwner:
+		if (!AddOwnerOnlyActor(ActorInfo))
+		{
+			PendingOwnerOnlyActors.Add(Actor);
+		}
+		break;
+	case EPBOActorRoute::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case EPBOActorRoute::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case EPBOActorRoute::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void UPBOReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	EPBOActorRoute Route = EPBOActorRoute::NotRouted;
+	if (!ActorRoutes.RemoveAndCopyValue(ActorInfo.Actor, Route))
+	{
+		UE_LOG(LogMotionInterpolator, Warning, TEXT("%s is removed from the replication graph without having been added"), *GetNameSafe(ActorInfo.Actor));
+		return;
+	}
+
+	switch (Route)
+	{
+	case EPBOActorRoute::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case EPBOActorRoute::OnlyRelevantToOwner:
+	{
+		TWeakObjectPtr<UNetConnection> Connection;
+		if (OwnerOnlyActorConnections.RemoveAndCopyValue(ActorInfo.Actor, Connection))
+		{
+			UReplicationGraphNode_ActorList** OwnerOnlyNode = OwnerOnlyNodes.Find(Connection.Get());
+			if (OwnerOnlyNode != nullptr)
+			{
+				(*OwnerOnlyNode)->NotifyRemoveNetworkActor(ActorInfo);
+			}
+		}
+		else
+		{
+			PendingOwnerOnlyActors.Remove(ActorInfo.Actor);
+		}
+		break;
+	}
+	case EPBOActorRoute::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case EPBOActorRoute::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case EPBOActorRoute::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+}
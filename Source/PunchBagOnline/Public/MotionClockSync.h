@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** One request/response exchange with the server, all times in seconds */
+struct FMotionClockSample
+{
+	/** Local clock when the response arrived */
+	double LocalTime = 0.0;
+	/** Server clock minus local clock, assuming a symmetric route */
+	double Offset = 0.0;
+	double RoundTripTime = 0.0;
+};
+
+/**
+ * Client estimate of the server clock from NTP style timestamped exchanges.
+ * Of the last few samples only the one with the lowest round trip time is trusted, since queuing delays only ever add to it.
+ * Small errors are slewed out and feed a drift estimate, large ones step the clock.
+ * All times are doubles, so precision holds on long running servers.
+ */
+struct PUNCHBAGONLINE_API FMotionClockSync
+{
+public:
+	static constexpr int32 FilterSize = 8;
+
+	/** Adds the exchange started at ClientSendTime and answered with ServerTime, both local times are on the same monotonic clock */
+	void AddSample(double ClientSendTime, double ServerTime, double ClientReceiveTime);
+
+	void Reset();
+
+	bool IsSynchronized() const { return bIsSynchronized; }
+
+	/** Server clock at the given local time */
+	double GetServerTime(double LocalTime) const;
+
+	double GetOffset() const { return BaseOffset; }
+	/** Seconds the server clock gains per local second */
+	double GetDrift() const { return Drift; }
+	/** Round trip time of the sample the estimate is based on */
+	double GetRoundTripTime() const { return BaseRoundTripTime; }
+	int32 GetNumSamples() const { return NumSamples; }
+
+	/** Errors above this step the clock instead of slewing it */
+	double StepThreshold = 0.1;
+	/** Share of the error corrected per accepted sample */
+	double OffsetGain = 0.25;
+	double DriftGain = 0.05;
+	/** Drift is clamped to +-MaxDrift, 500 ppm like NTP */
+	double MaxDrift = 0.0005;
+
+private:
+	FMotionClockSample Samples[FilterSize];
+	int32 NumSamples = 0;
+
+	bool bIsSynchronized = false;
+	double BaseLocalTime = 0.0;
+	double BaseOffset = 0.0;
+	double BaseRoundTripTime = 0.0;
+	double Drift = 0.0;
+};
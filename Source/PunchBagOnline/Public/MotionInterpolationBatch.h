@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MotionInterpolatorComponent.h"
+
+/**
+ * Snapshot segments of many interpolators stored as a structure of arrays and interpolated four at a time with VectorRegister math.
+ * Matches UMotionInterpolatorComponent::Interpolate within float rounding. Locations, velocities and PredictionBlend rotations are vectorized,
+ * Hermite rotations need quaternion slerps and still go through IntegrateAngularVelocity one segment at a time.
+ */
+class PUNCHBAGONLINE_API FMotionInterpolationBatch
+{
+public:
+	/** Makes room for NumSegments unset segments, allocations are kept between frames */
+	void Reset(int32 InNumSegments);
+	int32 Num() const { return NumSegments; }
+
+	/** Safe to call from several threads for distinct indices */
+	void SetSegment(int32 Index, const FMotionSnapshot& First, const FMotionSnapshot& Second, double TargetTime, EMotionInterpolationMode Mode);
+	/** Reads buffered snapshots in place, sync targets aren't interpolated by the kernel */
+	void SetSegment(int32 Index, const FMotionBufferedSnapshot& First, const FMotionBufferedSnapshot& Second, double TargetTime, EMotionInterpolationMode Mode);
+	bool IsSegmentSet(int32 Index) const { return SegmentModes[Index] != 0; }
+
+	/** Interpolates every set segment */
+	void Interpolate();
+
+	/** Interpolated snapshot of a set segment */
+	FMotionSnapshot GetResult(int32 Index) const;
+
+private:
+	enum EChannel : int32
+	{
+		LocationX, LocationY, LocationZ,
+		Pitch, Yaw, Roll,
+		VelocityX, VelocityY, VelocityZ,
+		AngularVelocityX, AngularVelocityY, AngularVelocityZ,
+		Timestamp,
+		NumChannels
+	};
+
+	using FChannel = TArray<float, TAlignedHeapAllocator<16>>;
+
+	static void SetChannels(FChannel* Channels, int32 Index, const FMotionSnapshot& Snapshot);
+	static void SetChannels(FChannel* Channels, int32 Index, const FMotionBufferedSnapshot& Entry);
+	/** Lanes hold times relative to the first snapshot, absolute synced times don't fit in floats */
+	void SetSegmentTimes(int32 Index, double FirstTime, double SecondTime, double TargetTime, EMotionInterpolationMode Mode);
+
+	FChannel First[NumChannels];
+	FChannel Second[NumChannels];
+	FChannel Result[NumChannels];
+	FChannel TargetTimes;
+	/** Synced time of the first snapshot of each segment */
+	TArray<double> BaseTimes;
+	/** 1 for Hermite segments, so lanes can be masked */
+	FChannel HermiteMask;
+	/** Normalized segment time, kept for the scalar Hermite rotations */
+	FChannel Alphas;
+	/** 0 while unset, otherwise EMotionInterpolationMode + 1 */
+	TArray<uint8> SegmentModes;
+	int32 NumSegments = 0;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MotionInterpolatorBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless benchmark of the motion interpolation stack.
+ * Spawns simulated proxy actors with interpolators in a game world and feeds them scripted motion,
+ * encoded and acked by the sync channel's send and receive streams, and sent as serialized batches over a simulated lossy, jittery link.
+ * Writes game thread time per tick, bytes per second of the link, buffer underruns and error against the scripted motion to a JSON file.
+ *
+ * UE4Editor-Cmd PunchBagOnline -run=MotionInterpolatorBenchmark -nullrhi -unattended
+ *     -Actors=256 -Duration=20 -TickRate=60 -SendPeriod=0.05 -PktLag=100 -PktLagVariance=20 -PktLoss=2 -Interpolation=Hermite -Output=<path>.json
+ *
+ * With -Kernel, compares the vectorized FMotionInterpolationBatch against the scalar interpolation for 1k to 10k objects instead:
+ * UE4Editor-Cmd PunchBagOnline -run=MotionInterpolatorBenchmark -nullrhi -unattended -Kernel -Iterations=200 -Interpolation=Hermite -Output=<path>.json
+ */
+UCLASS()
+class UMotionInterpolatorBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMotionInterpolatorBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	UFUNCTION()
+	void HandleNotEnoughData();
+
+	int32 NumUnderruns = 0;
+};
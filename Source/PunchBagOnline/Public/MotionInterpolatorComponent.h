@@ -2,6 +2,11 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Containers/Queue.h"
+#include "Engine/NetSerialization.h"
+#include "HAL/ThreadSafeBool.h"
+#include "MotionSnapshotBuffer.h"
+#include "MotionJitterEstimator.h"
 #include "MotionInterpolatorComponent.generated.h"
 
 UENUM()
@@ -10,11 +15,49 @@ enum class EMotionSnapshotFlags : uint8
 	None				= 0x0,
 	HasVelocity			= 0x1,
 	HasAngularVelocity	= 0x2,
+	HasTransforms		= 0x4,
+	HasAuthorityEpoch	= 0x8,
+	HasSamples			= 0x10,
 
-	FLAGS_COUNT			= 0x2
+	FLAGS_COUNT			= 0x5
 };
 ENUM_CLASS_FLAGS(EMotionSnapshotFlags)
 
+/** Upper bound of UMotionInterpolatorComponent::SyncTargets, snapshots with more transforms are rejected */
+static constexpr int32 MaxMotionSyncTargets = 32;
+/** Upper bound of UMotionInterpolatorComponent::MaxSamplesPerSnapshot, snapshots with more samples are rejected */
+static constexpr int32 MaxMotionSnapshotSamples = 16;
+
+/** Transform of an additional sync target, in the space of the primary synced component */
+USTRUCT(BlueprintType)
+struct FMotionSnapshotTransform
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FVector Location = FVector::ZeroVector;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FQuat Rotation = FQuat::Identity;
+
+	FMotionSnapshotTransform() {}
+	explicit FMotionSnapshotTransform(const FTransform& Transform) : Location(Transform.GetLocation()), Rotation(Transform.GetRotation()) {}
+
+	FTransform ToTransform() const { return FTransform(Rotation, Location); }
+
+	static FMotionSnapshotTransform Lerp(const FMotionSnapshotTransform& A, const FMotionSnapshotTransform& B, float Alpha);
+};
+
+/** Pose of the synced component recorded between two sent snapshots, see UMotionInterpolatorComponent::SampleRate */
+struct FMotionSnapshotSample
+{
+	FVector Location = FVector::ZeroVector;
+	FRotator Rotation = FRotator::ZeroRotator;
+	double Timestamp = 0.0;
+	/** Sync targets at the same time, like FMotionSnapshot::Transforms. As many as the snapshot carrying the sample */
+	TArray<FMotionSnapshotTransform> Transforms;
+};
+
 USTRUCT(BlueprintType)
 struct FMotionSnapshot
 {
@@ -29,12 +72,20 @@ public:
 	FVector Velocity;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
 	FVector AngularVelocity;
+	/** Synced time in seconds. Blueprints have no doubles, and floats lose milliseconds after a few hours of uptime */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	double Timestamp;
+	/** One per sync target of the interpolator, in declaration order. Share the snapshot's timestamp */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
-	float Timestamp;
+	TArray<FMotionSnapshotTransform> Transforms;
 
-	float ArrivalTime = 0;
+	double ArrivalTime = 0.0;
+	/** Authority epoch of the sender, see UMotionInterpolatorComponent::ClaimAuthority */
+	uint16 AuthorityEpoch = 0;
+	/** Poses recorded since the previous sent snapshot, oldest first. Receivers buffer them as snapshots of their own */
+	TArray<FMotionSnapshotSample> Samples;
 
-	FMotionSnapshot(FVector InLocation, FQuat InRotation, FVector InVelocity, FVector InAngularVelocity, float InTimestamp) :
+	FMotionSnapshot(FVector InLocation, FQuat InRotation, FVector InVelocity, FVector InAngularVelocity, double InTimestamp) :
 		Location(InLocation),
 		Rotation(InRotation),
 		Velocity(InVelocity),
@@ -50,7 +101,7 @@ public:
 		Timestamp()
 	{}
 
-	FMotionSnapshot(const USceneComponent& InComponent, float InTimestamp);
+	FMotionSnapshot(const USceneComponent& InComponent, double InTimestamp);
 
 	FMotionSnapshot(const USceneComponent& InComponent);
 
@@ -68,8 +119,180 @@ struct TStructOpsTypeTraits<FMotionSnapshot> : public TStructOpsTypeTraitsBase2<
 	};
 };
 
+USTRUCT(BlueprintType)
+struct FMotionVectorPrecision
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** Quantization step, in units of the synced value */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator", meta = (ClampMin = "0.0001"))
+	float Step = 0.1f;
+	/** Each axis is clamped to [-MaxValue, MaxValue] */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator", meta = (ClampMin = "0.0"))
+	float MaxValue = 100000.0f;
+
+	FMotionVectorPrecision() {}
+	FMotionVectorPrecision(float InStep, float InMaxValue) : Step(InStep), MaxValue(InMaxValue) {}
+
+	/** Bits needed for one axis at MaxValue */
+	int32 GetBitsPerAxis() const;
+};
+
+/** Precision of one sync target transform, see UMotionInterpolatorComponent::SyncTargets */
+USTRUCT(BlueprintType)
+struct FMotionTransformPrecision
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** Relative to the synced component, so small steps and ranges do for hands and devices on a pawn */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FMotionVectorPrecision Location = FMotionVectorPrecision(0.01f, 1000.0f);
+	/** Bits for each of the three smallest quaternion components */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator", meta = (ClampMin = "4", ClampMax = "20"))
+	int32 RotationBits = 12;
+};
+
+/** Precision snapshots of one interpolator are quantized with before they are sent */
+USTRUCT(BlueprintType)
+struct FMotionSnapshotPrecision
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FMotionVectorPrecision Location = FMotionVectorPrecision(0.1f, 1000000.0f);
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FMotionVectorPrecision Velocity = FMotionVectorPrecision(0.1f, 100000.0f);
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FMotionVectorPrecision AngularVelocity = FMotionVectorPrecision(0.1f, 100000.0f);
+	/** Bits for each of the three smallest quaternion components */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator", meta = (ClampMin = "4", ClampMax = "20"))
+	int32 RotationBits = 14;
+
+	/** One per sync target, filled in by UMotionInterpolatorComponent::GetSnapshotPrecision */
+	TArray<FMotionTransformPrecision, TInlineAllocator<4>> Transforms;
+	/** Most samples sent with a snapshot, filled in by UMotionInterpolatorComponent::GetSnapshotPrecision. Only used for size estimates */
+	int32 NumSamples = 0;
+
+	/** Precision of a sync target transform, the default one past the known targets */
+	const FMotionTransformPrecision& GetTransformPrecision(int32 Index) const;
+
+	/** Upper bound of a full (not delta encoded) snapshot size */
+	int32 GetMaxFullSnapshotBits() const;
+	/** Size of a delta snapshot when nothing changed since the baseline */
+	int32 GetMinDeltaSnapshotBits() const;
+};
+
+/** An additional component or bone synced through the snapshots of an interpolator */
+USTRUCT(BlueprintType)
+struct FMotionSyncTarget
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** Component of the owner, a child actor component stands for the root of its child actor */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FName ComponentName = NAME_None;
+	/**
+	 * Bone of ComponentName when it is a skinned mesh, None syncs the component itself.
+	 * Only poseable mesh bones are written on receivers, skeletal mesh bones are left to their anim instance, see UMotionInterpolatorComponent::GetSyncTargetTransform
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FName BoneName = NAME_None;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FMotionTransformPrecision Precision;
+};
+
+UENUM(BlueprintType)
+enum class EMotionPrecisionProfile : uint8
+{
+	/** Roughly the precision of the uncompressed snapshot RPCs */
+	Default,
+	/** Fine location and rotation, bounded speeds of a tracked VR device */
+	TrackedDevice,
+	/** Coarse velocities for physics props like the punching bag */
+	PhysicsProp,
+	/** Uses CustomPrecision */
+	Custom
+};
+
+UENUM(BlueprintType)
+enum class EMotionInterpolationMode : uint8
+{
+	/** Blends forward and backward linear predictions, eases rotation between the two snapshots */
+	PredictionBlend,
+	/** Cubic Hermite location through both velocities, rotation slerped between both angular velocity predictions. Extrapolation is bounded */
+	Hermite
+};
+
+UENUM(BlueprintType)
+enum class EMotionApplyMode : uint8
+{
+	/** Teleports the component and sets its physics velocities, one synchronous physics update per application */
+	Teleport,
+	/**
+	 * Moves the component without touching physics and queues its body for one batched physics write per frame.
+	 * Kinematic bodies get a kinematic target and sweep to it during the next step, keeping their contacts.
+	 * Simulated bodies get their pose and velocities. Components without a single body of their own fall back to Teleport.
+	 */
+	PhysicsTarget
+};
+
+UENUM(BlueprintType)
+enum class EMotionInterpolatorTickMode : uint8
+{
+	/** Ticked together with every other interpolator by UMotionInterpolatorSubsystem */
+	Batched,
+	/** Ticked by its own component tick function */
+	PerComponent
+};
+
+/** A punch landing on a synced body, sent instead of streaming its swing at a high rate. See UMotionInterpolatorComponent::SendImpact */
+USTRUCT(BlueprintType)
+struct FMotionImpactEvent
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** World location the impulse is applied at */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FVector_NetQuantize10 Location;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FVector_NetQuantize10 Impulse;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	AActor* Hitter = nullptr;
+	/** Synced time of the hit on the sender */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	double Timestamp = 0.0;
+};
+
+/** Snapshot decoded off the game thread, waiting for the next drain of UMotionInterpolatorSubsystem::DrainReceivedSnapshots */
+struct FMotionReceivedSnapshot
+{
+	FMotionSnapshot Snapshot;
+	TWeakObjectPtr<class UMotionSyncChannelComponent> SourceChannel;
+};
+
+/** Per-frame state shared by the component tick and the batched subsystem tick */
+struct FMotionInterpolatorTickContext
+{
+	class USceneComponent* Component = nullptr;
+	double SyncedTime = 0.0;
+	double LookupTime = 0.0;
+	bool bNeedsLookup = false;
+	/** The lookup fell between two snapshots, Snapshot is filled from the batch kernel after it ran. Never set with sync targets */
+	bool bIsBatchInterpolated = false;
+	FMotionSnapshot Snapshot;
+	int OffBorder = 0;
+	/** The lookup went past the newest snapshot. Counted by FinishMotionTick, stats aren't touched off the game thread */
+	bool bIsExtrapolated = false;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMotionInterpolatorDelegate, const FMotionSnapshot&, Snapshot);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FMotionInterpolatorErrorDelegate);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMotionImpactDelegate, const FMotionImpactEvent&, Impact);
 DECLARE_DELEGATE(FAdditionalDelayDelegate);
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
@@ -80,15 +303,80 @@ class PUNCHBAGONLINE_API UMotionInterpolatorComponent : public UActorComponent
 public:	
 	UMotionInterpolatorComponent();
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Game thread: handles authority and sending, decides whether a snapshot lookup is needed */
+	void PrepareMotionTick(float DeltaTime, double CurrentSyncedTime, FMotionInterpolatorTickContext& Context);
+	/**
+	 * Any thread: looks up the snapshot to apply, only reads the snapshot buffer.
+	 * With a batch, segments that need interpolating are written to it at BatchIndex instead of being interpolated here.
+	 */
+	void ResolveMotionTick(FMotionInterpolatorTickContext& Context, class FMotionInterpolationBatch* Batch = nullptr, int32 BatchIndex = INDEX_NONE);
+	/** Game thread: applies the looked up snapshot and updates network delays */
+	void FinishMotionTick(float DeltaTime, FMotionInterpolatorTickContext& Context);
 
 	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
 	void SetComponentOverride(class USceneComponent* InComponentOverride);
 
+	/** Component the snapshots are taken from and applied to, null until resolved */
+	class USceneComponent* GetSyncedComponent() const;
+
+	/** Looks up the synced component and the sync targets again, they are cached otherwise. Needed after adding or renaming components */
+	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
+	void InvalidateSyncBindings();
+
+	/**
+	 * World transform last applied to a sync target.
+	 * Skeletal mesh bones are posed by their animation, which can read them from here, poseable mesh bones are set directly.
+	 */
+	UFUNCTION(BlueprintPure, Category = "MotionInterpolator")
+	bool GetSyncTargetTransform(int32 TargetIndex, FTransform& OutTransform) const;
+
 	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
 	void AddSnapshot(const FMotionSnapshot& Snapshot);
+	void GetSnapshotAtTime(double TargetTime, bool CanExtrapolate, FMotionSnapshot& Result, int& OffBorder, bool* bOutIsExtrapolated = nullptr);
+	/** GetSnapshotAtTime for Blueprints, Age is in seconds before the current synced time */
 	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
-	void GetSnapshotAtTime(float TargetTime, bool CanExtrapolate, FMotionSnapshot& Result, int& OffBorder);
+	void GetSnapshotAtAge(float Age, bool CanExtrapolate, FMotionSnapshot& Result, int& OffBorder);
+	/** Seconds from the snapshot's Timestamp to the current synced time, Blueprints can't read the double timestamp itself */
+	UFUNCTION(BlueprintPure, Category = "MotionInterpolator")
+	float GetSnapshotAge(const FMotionSnapshot& Snapshot) const;
+
+	/** Sends the snapshot to every other machine, batched through the local UMotionSyncChannelComponent when possible */
+	void SendSnapshot(const FMotionSnapshot& Snapshot);
+	/**
+	 * Adds a snapshot received from the network and updates the network delay.
+	 * The delay estimate of SourceChannel is shared with every interpolator on the same connection, without one the component keeps its own.
+	 */
+	void ReceiveSnapshot(const FMotionSnapshot& Snapshot, class UMotionSyncChannelComponent* SourceChannel = nullptr);
+	/** Any thread: queues a decoded snapshot for the next drain. True if it is the first one since the last drain */
+	bool EnqueueReceivedSnapshot(FMotionReceivedSnapshot&& Received);
+	/** Game thread, decode tasks may queue more meanwhile */
+	bool DequeueReceivedSnapshot(FMotionReceivedSnapshot& OutReceived);
+
+	UFUNCTION(BlueprintPure, Category = "MotionInterpolator")
+	FMotionSnapshotPrecision GetSnapshotPrecision() const;
+
+	/** Upper bound of a full snapshot of this interpolator, in bits */
+	UFUNCTION(BlueprintPure, Category = "MotionInterpolator")
+	int32 GetMaxSnapshotBits() const;
+
+	float GetAdditionalNetworkDelay() const { return CurrentAdditionalNetworkDelay; }
+	/** Share of the buffer currently filled */
+	float GetBufferOccupancy() const { return static_cast<float>(Snapshots.Num()) / GetBufferCapacity(); }
+	/** BufferSize snapshots, plus room for their samples */
+	int32 GetBufferCapacity() const;
+
+	/** Desired time between two sent snapshots, the send scheduler may go faster or slower */
+	float GetSyncPeriodHint() const;
+	/** Seconds between two samples of the synced pose, 0 without sampling */
+	double GetSampleInterval() const { return IsSampling() ? 1.0 / SampleRate : 0.0; }
+
+	/** Compact id used to address this interpolator in snapshot batches, 0 until assigned by the server */
+	uint16 GetSyncNetId() const { return SyncNetId; }
 
 	UFUNCTION(Server, Unreliable)
 	void ServerSendSnapshot(const FMotionSnapshot& InSnapshot, FGuid SenderGuid);
@@ -97,6 +385,23 @@ public:
 	UFUNCTION(Client, Unreliable)
 	void ClientSendSnapshot(const FMotionSnapshot& InSnapshot);
 
+	/**
+	 * Applies an impulse where a punch landed and sends it to every other machine, which simulates the swing on its own body.
+	 * Snapshots keep coming at SyncPeriod and are blended in for ImpactCorrectionDuration, so no high frequency updates are needed.
+	 * Proxies apply received impacts once their lookup time reaches the impact, bodies that don't simulate physics only follow snapshots.
+	 * Clients rarely own what they hit, so impacts go through the motion sync channel of their player controller.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator|Impact")
+	void SendImpact(FVector Location, FVector Impulse, AActor* Hitter);
+	/**
+	 * Applies an impact received from the network, the server forwards it to everyone else but the source channel and SenderGuid.
+	 * The server drops impacts away from the synced component or out of the sending player's reach.
+	 */
+	void ReceiveImpact(const FMotionImpactEvent& Impact, class UMotionSyncChannelComponent* SourceChannel = nullptr, const FGuid& SenderGuid = FGuid());
+	/** For clients without a motion sync channel, the others get impacts through theirs */
+	UFUNCTION(NetMulticast, Reliable)
+	void MulticastSendImpact(const FMotionImpactEvent& Impact, FGuid SenderGuid);
+
 	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
 	void ServerTakeOwnership_Implementation(AActor* newOwner, float OwnershipDuration);
 	UFUNCTION(Server, Reliable)
@@ -104,12 +409,23 @@ public:
 	UFUNCTION(Client, Reliable)
 	void ClientReleaseOwnership();
 
+	/** Copies the whole buffer, GetNumSnapshots and GetSnapshot read one snapshot at a time */
 	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
-	TArray<FMotionSnapshot> GetSnapshots() { return Snapshots; }
+	TArray<FMotionSnapshot> GetSnapshots();
+	UFUNCTION(BlueprintPure, Category = "MotionInterpolator")
+	int32 GetNumSnapshots() const { return Snapshots.Num(); }
+	/** Buffered snapshot from oldest to newest, returns false for an invalid index */
+	UFUNCTION(BlueprintPure, Category = "MotionInterpolator")
+	bool GetSnapshot(int32 Index, FMotionSnapshot& OutSnapshot) const;
+	const FMotionSnapshotBuffer& GetSnapshotBuffer() const { return Snapshots; }
 
+	/** Synced time the buffered snapshots are currently played at */
+	double GetLookupTime();
+	/** Seconds the buffered snapshots are played behind the current synced time, GetLookupTime for Blueprints */
 	UFUNCTION(BlueprintPure, Category = "MotionInterpolator")
-	float GetLookupTime();
+	float GetLookupDelay();
 
+	/** Ignored while bImpactsReplaceHighFreqUpdates is set, ownership handoffs still start their own */
 	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
 	void EnableTempHighFreqUpdate();
 	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
@@ -118,21 +434,89 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator")
 	void OvertakeMovementAuthority(float Duration);
 
-	FMotionSnapshot Interpolate(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, float TargetTime);
+	/**
+	 * Takes movement authority right away, without reliable RPCs or a new net owner.
+	 * The next authority epoch travels with the snapshot stream and the server grants the first claim of each epoch,
+	 * a client that lost a conflict gives authority back when snapshots of an epoch at least as new as its claim arrive.
+	 * The server takes authority back after AuthorityClaimDuration. Clients need snapshot batching, claims can't go through owner only RPCs.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator|Authority")
+	void ClaimAuthority();
+	/** Whether this client's last claim hasn't been superseded yet */
+	UFUNCTION(BlueprintPure, Category = "MotionInterpolator|Authority")
+	bool HasClaimedAuthority() const { return bHasClaimedAuthority; }
+	/** Newest authority epoch this machine knows of */
+	uint16 GetAuthorityEpoch() const { return AuthorityEpoch; }
+	/** Server: whether a snapshot from the connection may drive this interpolator, newer epochs are granted as claims */
+	bool AcceptSnapshotFrom(const FMotionSnapshot& Snapshot, class UNetConnection* Connection);
+
+	/** Ticks again after sleeping at rest, see bAllowTickSleep. Call it after moving the synced component by hand */
+	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator|Rest")
+	void WakeTick();
+	UFUNCTION(BlueprintPure, Category = "MotionInterpolator|Rest")
+	bool IsTickSleeping() const { return bIsTickSleeping; }
+
+	/** Server: wakes the actor from net dormancy, also done on motion, claims and ownership changes. Call it on impacts that don't move the synced component */
+	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator|Dormancy")
+	void WakeNetDormancy();
+
+	FMotionSnapshot Interpolate(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, double TargetTime);
 	FMotionSnapshot SimpleInterpolate(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, float Alpha);
-	FMotionSnapshot Extrapolate(const FMotionSnapshot& Snapshot, float TargetTime);
+	FMotionSnapshot Extrapolate(const FMotionSnapshot& Snapshot, double TargetTime);
+
+	/** Blends the sync target transforms, Second's are taken when the two have different targets */
+	static void InterpolateTransforms(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, float Alpha, FMotionSnapshot& Result);
+
+	/** Rotation after turning at the given world space angular velocity, in degrees per second, for Time seconds */
+	static FQuat IntegrateAngularVelocity(const FQuat& Rotation, const FVector& AngularVelocity, float Time);
 
 	UPROPERTY(BlueprintAssignable, Category = "MotionInterpolator")
 	FMotionInterpolatorDelegate OnSnapshotAdded;
 	UPROPERTY(BlueprintAssignable, Category = "MotionInterpolator")
 	FMotionInterpolatorErrorDelegate OnNotEnoughData;
+	/** An impact was applied to the synced body, for effects and sounds */
+	UPROPERTY(BlueprintAssignable, Category = "MotionInterpolator|Impact")
+	FMotionImpactDelegate OnImpactApplied;
 
 	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
 	bool UseExtrapolation = false;
 
+	/** Higher order modes keep the same error at lower send rates */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	EMotionInterpolationMode InterpolationMode = EMotionInterpolationMode::PredictionBlend;
+	/** Hermite mode: snapshots are not extrapolated further than this */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator", meta = (EditCondition = "InterpolationMode == EMotionInterpolationMode::Hermite"))
+	float MaxExtrapolationTime = 0.25f;
+	/** Hermite mode: extrapolated locations stay within this distance of the newest snapshot */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator", meta = (EditCondition = "InterpolationMode == EMotionInterpolationMode::Hermite"))
+	float MaxExtrapolationDistance = 100.0f;
+
+	/** Send snapshots in per-connection batches instead of one RPC per snapshot */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	bool bUseSnapshotBatching = true;
+
+	/** Replicated from the server, so both ends of a stream quantize and dequantize with the same scale */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "MotionInterpolator")
+	EMotionPrecisionProfile PrecisionProfile = EMotionPrecisionProfile::Default;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category = "MotionInterpolator", meta = (EditCondition = "PrecisionProfile == EMotionPrecisionProfile::Custom"))
+	FMotionSnapshotPrecision CustomPrecision;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	EMotionApplyMode ApplyMode = EMotionApplyMode::Teleport;
+
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	EMotionInterpolatorTickMode TickMode = EMotionInterpolatorTickMode::Batched;
+
 	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
 	FName SyncedComponentName = NAME_None;
 
+	/**
+	 * More components and bones sent with the same snapshots, relative to the synced component, like the HMD, the motion controllers and the hand bones of a VR pawn.
+	 * Bones of one mesh are applied in this order, so parents go before their children.
+	 */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	TArray<FMotionSyncTarget> SyncTargets;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator", meta = (ExposeOnSpawn = true))
 	int BufferSize = 10;
 
@@ -153,28 +537,237 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
 	float SnapPeriod = 0.2f;
 
+	/**
+	 * Records the synced pose this many times per second of synced time and sends the samples with the next snapshot,
+	 * so receivers rebuild fast motion like punches between two sends. Samples are the poses of the frames a fixed rate clock
+	 * falls on, sync targets included, and are never blended between frames. Frames slower than the rate give one sample each.
+	 * 0 only sends the pose of the sending frame.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Sampling", meta = (ClampMin = "0.0"))
+	float SampleRate = 0.0f;
+	/** Older samples are dropped when sends are further apart, e.g. while dead reckoning */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Sampling", meta = (ClampMin = "1", ClampMax = "16"))
+	int32 MaxSamplesPerSnapshot = 8;
+
+	/** Seconds after an impact during which the local simulation is blended toward snapshots instead of snapped to them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Impact")
+	float ImpactCorrectionDuration = 2.0f;
+	/** Seconds for the blend to take out all but a third of the error */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Impact")
+	float ImpactCorrectionTime = 0.3f;
+	/** Local simulations further off than this are snapped to the snapshots */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Impact")
+	float ImpactSnapDistance = 50.0f;
+	/** Server: received impulses are clamped to this size, 0 doesn't clamp. The default lets a 40 kg bag gain 5 m/s */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Impact", meta = (ClampMin = "0.0"))
+	float MaxImpactImpulse = 20000.0f;
+	/** Server: received impacts further than this from the synced component's bounds are dropped, covers the motion during the sender's delay */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Impact", meta = (ClampMin = "0.0"))
+	float MaxImpactLocationError = 50.0f;
+	/** Server: received impacts further than this from the sending player's pawn and view point, or from the hitter, are dropped */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Impact", meta = (ClampMin = "0.0"))
+	float MaxImpactInstigatorDistance = 250.0f;
+	/**
+	 * Set once the hit handlers send their hits with SendImpact, Blueprint calls of EnableTempHighFreqUpdate then do nothing.
+	 * Off by default: no shipped Blueprint calls SendImpact yet, the pawn drives high frequency updates with SetHighFreqUpdateEnabled.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Impact")
+	bool bImpactsReplaceHighFreqUpdates = false;
+
+	/**
+	 * Only send when receivers, predicting from the last sent snapshot, would be off by more than the tolerances.
+	 * SyncPeriod stays the highest send rate. Receivers hold or extrapolate the newest snapshot in between.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|DeadReckoning")
+	bool bUseDeadReckoning = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|DeadReckoning", meta = (EditCondition = "bUseDeadReckoning"))
+	float DeadReckoningLocationTolerance = 1.0f;
+	/** Degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|DeadReckoning", meta = (EditCondition = "bUseDeadReckoning"))
+	float DeadReckoningRotationTolerance = 1.0f;
+	/** A snapshot is sent at least this often, so late joiners and lost packets catch up */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|DeadReckoning", meta = (EditCondition = "bUseDeadReckoning"))
+	float DeadReckoningKeepalivePeriod = 1.0f;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
 	float AuthorityBlendTime = 0.5f;
 
+	/** Whether clients may take authority with ClaimAuthority, leave off for pawns so nobody else can move them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Authority")
+	bool bAllowAuthorityClaims = false;
+	/** Server: seconds a granted claim lasts, every new claim starts it again */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Authority", meta = (EditCondition = "bAllowAuthorityClaims"))
+	float AuthorityClaimDuration = 1.0f;
+
+	/**
+	 * Server: the actor goes net dormant once the synced component rested for DormancyRestTime without a net owner or claim,
+	 * so the replication graph gathers it as a static actor. Snapshots still go through the channels.
+	 * On by default, which covers the punching bag. Turn it off per actor, or set the actor's NetDormancy to DORM_Never.
+	 * Dormant actors drop multicasts, so the actor stays awake while any connection has no sync channel.
+	 * The graph reads it when the actor starts replicating, changing it later keeps the actor's route.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Dormancy")
+	bool bDriveNetDormancy = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Dormancy", meta = (EditCondition = "bDriveNetDormancy"))
+	float DormancyRestTime = 2.0f;
+
+	/**
+	 * Stops ticking while nothing moves: server authorities without owner or claim that rested for TickSleepDelay,
+	 * and proxies whose snapshot stream ended at rest. Sleeping authorities still send a snapshot every DeadReckoningKeepalivePeriod.
+	 * Woken by snapshots that move, claims and ownership changes, and by physics wake events when the synced body generates them.
+	 * Bodies without wake events are noticed by the next keepalive.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Rest")
+	bool bAllowTickSleep = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Rest", meta = (EditCondition = "bAllowTickSleep"))
+	float TickSleepDelay = 1.0f;
+	/** The synced component rests below this speed, for tick sleeping and dormancy */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Rest")
+	float RestLinearThreshold = 1.0f;
+	/** Degrees per second */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator|Rest")
+	float RestAngularThreshold = 5.0f;
+
 private:
+	UFUNCTION()
+	void OnRep_SyncNetId();
+	class UMotionInterpolatorSubsystem* GetSubsystem() const;
+	/** Null when the world isn't recording */
+	class FMotionSnapshotRecorder* GetRecorder() const;
+	uint32 GetRecordingStreamId();
+	/** Whether snapshots go through a channel send scheduler instead of the SyncPeriod timer */
+	bool IsSendScheduled() const;
+	/** Client: snapshots and impacts come through the local channel, so the fallback multicasts are ignored */
+	bool IsReceivingThroughChannel() const;
+
+	UPROPERTY(ReplicatedUsing = OnRep_SyncNetId)
+	uint16 SyncNetId = 0;
+
+	/** Whether receivers predicting from the last sent snapshot are off by more than the dead reckoning tolerances */
+	bool HasDeadReckoningError(const FMotionSnapshot& Snapshot);
+	/** Whether the pose moved by more than the dead reckoning tolerances, sync targets included */
+	bool HasMovedSince(const FMotionSnapshot& From, const FMotionSnapshot& To) const;
+
+	/** Applies the looked up snapshot to the synced component according to ApplyMode */
+	void ApplySnapshot(FMotionSnapshot& Snapshot, class USceneComponent& Component);
+
+	/** Server: hands the epoch to the claiming connection */
+	void GrantAuthorityClaim(uint16 Epoch, class UNetConnection* Connection);
+	/** Server: takes authority back from the claiming client with an epoch of its own */
+	void RevokeAuthorityClaim();
+	/** Drops snapshots of superseded epochs and switches to newer ones, false if the snapshot is stale */
+	bool UpdateAuthorityEpoch(const FMotionSnapshot& Snapshot);
+	/** Adds the impulse to the synced body and starts blending snapshots in */
+	void ApplyImpact(const FMotionImpactEvent& Impact);
+	/** Server: whether a received impact is close to the synced component and within reach of whoever sent it */
+	bool IsImpactPlausible(const FMotionImpactEvent& Impact, const class UMotionSyncChannelComponent* SourceChannel) const;
+	/** High frequency updates of ownership handoffs, which impacts don't replace */
+	void StartTempHighFreqUpdate();
+	/** Proxies: applies the received impacts the lookup time reached */
+	void ApplyDueImpacts(double LookupTime);
+	/** Whether the local simulation of an impact is still blended toward snapshots */
+	bool IsCorrectingImpact(double SyncedTime) const { return SyncedTime < ImpactCorrectionEndTime; }
+	/** Whether the synced pose is recorded at SampleRate */
+	bool IsSampling() const;
+	/** Adds the pose of this frame to PendingSamples when the sample clock is due. Scheduled sends sample in the channels instead */
+	void RecordSamples(const class USceneComponent& Component, double SyncedTime);
+	/** Moves the pending samples older than the snapshot into it */
+	void TakePendingSamples(FMotionSnapshot& Snapshot);
+	/** Received samples as snapshots, velocities from their neighbours */
+	void ExpandSamples(const FMotionSnapshot& Snapshot, TArray<FMotionSnapshot>& OutSnapshots) const;
+	/** Server: puts the actor to sleep after it rested long enough, wakes it when it moves */
+	void UpdateNetDormancy(float DeltaTime, const class USceneComponent& Component);
+	/** Server: true while a connection without a sync channel relies on the multicast fallback */
+	bool NeedsMulticastFallback() const;
+	/** Whether the synced component moves slower than the rest thresholds */
+	bool IsAtRest(const class USceneComponent& Component) const;
+	bool IsSnapshotAtRest(const FMotionSnapshot& Snapshot) const;
+	/** Stops ticking once the interpolator has been idle for TickSleepDelay */
+	void UpdateTickSleep(float DeltaTime, const FMotionInterpolatorTickContext& Context);
+	void StartTickSleep(class USceneComponent& Component);
+	/** Snapshot of a sleeping authority, so late joiners and lost packets catch up */
+	void SendKeepaliveSnapshot();
+	UFUNCTION()
+	void OnSyncedComponentWake(class UPrimitiveComponent* WakingComponent, FName BoneName);
+
+	/** Index of the second snapshot around TargetTime when the two have to be interpolated, INDEX_NONE otherwise */
+	int32 FindInterpolationSegment(double TargetTime) const;
+
+	FMotionSnapshot HermiteInterpolate(const FMotionSnapshot& FirstSnapshot, const FMotionSnapshot& SecondSnapshot, double TargetTime) const;
+	FMotionSnapshot BoundedExtrapolate(const FMotionSnapshot& Snapshot, double TargetTime) const;
+
+	struct FSyncTargetBinding
+	{
+		TWeakObjectPtr<class USceneComponent> Component;
+		/** Bone of Component when the target is a bone */
+		int32 BoneIndex = INDEX_NONE;
+	};
+
 	class USceneComponent* GetComponentToSync();
-	float GetSnapshotsMaxDelay();
+	void ResolveSyncBindings();
+	static class USceneComponent* FindSyncComponent(const AActor* Owner, FName ComponentName);
+	/** Fills snapshot or sample transforms from the sync targets, relative to Component */
+	void CaptureSyncTargets(const class USceneComponent& Component, TArray<FMotionSnapshotTransform>& OutTransforms) const;
+	void ApplySyncTargets(const FMotionSnapshot& Snapshot, const class USceneComponent& Component);
+	/** Server: adds the pose to the subsystem's rewind history, in world space */
+	void RecordRewindPose(const FMotionSnapshot& Pose, const class USceneComponent& Component);
 	float GetLookupTimeOffset();
-	const class AGameStateBase* GetGameState();
-	class USceneComponent* ComponentToSync;
+	/** Frame time of the subsystem's synchronized clock */
+	double GetSyncedTime() const;
+	TWeakObjectPtr<class USceneComponent> ComponentToSync;
 	class USceneComponent* ComponentOverride;
-	TArray<FMotionSnapshot> Snapshots;
+	TArray<FSyncTargetBinding> SyncTargetBindings;
+	TArray<FTransform> AppliedSyncTargetTransforms;
+	bool bSyncBindingsResolved = false;
+	FMotionSnapshotBuffer Snapshots;
 	FGuid GUID = FGuid::NewGuid();
-	float AuthorityReleaseTime = 0.0f;
+	double AuthorityReleaseTime = 0.0;
 	float CurrentAuthorityBlendTime = 0.0f;
-	float LastSyncTime = 0.0f;
-	float LastSnapTime = 0.0f;
+	double LastSyncTime = 0.0;
+	double LastSnapTime = 0.0;
 	float TargetNetworkDelay = 0.0f;
 	float CurrentOwnershipDuration = 0.0f;
 	float CurrentAdditionalNetworkDelay = 0.0f;
 	float TargetAdditionalNetworkDelay = 0.0f;
 	float CurrentHightFreqSyncDuration = 0.0f;
+	FMotionSnapshot LastSentSnapshot;
+	bool bHasSentSnapshot = false;
+	/** Received impacts waiting for the lookup time, oldest first */
+	TArray<FMotionImpactEvent> PendingImpacts;
+	/** Synced time of the newest applied impact, older snapshots don't know about it */
+	double LastImpactTime = -MAX_dbl;
+	double ImpactCorrectionEndTime = 0.0;
+	/** Recorded since the previous sent snapshot */
+	TArray<FMotionSnapshotSample> PendingSamples;
+	/** Synced time the next sample is due, advanced by the sample interval so the rate doesn't drift with the frame rate */
+	double NextSampleTime = 0.0;
+	bool bIsSampleClockRunning = false;
+	/** Synced time the server asked the owner to release ownership */
+	double OwnershipReleaseStartTime = 0.0;
+	uint32 RecordingStreamId = 0;
+	/** Running average of the time between received snapshots */
+	float AverageSnapshotInterval = 0.0f;
+	FMotionJitterEstimator JitterEstimator;
 	FAdditionalDelayDelegate OnAdditionalDelayReached;
 	bool HadMovementAuthority = false;
-	const class AGameStateBase* CachedGameState = nullptr;
+	uint16 AuthorityEpoch = 0;
+	/** Clients adopt the epoch of their first snapshot, wherever the server's counter is */
+	bool bHasAuthorityEpoch = false;
+	/** Client: holds authority through a claim of AuthorityEpoch */
+	bool bHasClaimedAuthority = false;
+	/** Server: a client holds authority through a claim of AuthorityEpoch */
+	bool bIsClaimedByClient = false;
+	TWeakObjectPtr<class UNetConnection> AuthorityClaimConnection;
+	double AuthorityClaimExpireTime = 0.0;
+	/** Seconds the synced component has been at rest */
+	float NetRestTime = 0.0f;
+	/** Seconds the interpolator has been idle while ticking */
+	float IdleTime = 0.0f;
+	bool bIsTickSleeping = false;
+	FTimerHandle KeepaliveTimerHandle;
+	TWeakObjectPtr<class UPrimitiveComponent> WakeEventComponent;
+	/** Filled by the subsystem's decode tasks, one per receiving channel, so several producers */
+	TQueue<FMotionReceivedSnapshot, EQueueMode::Mpsc> ReceivedSnapshots;
+	FThreadSafeBool bHasReceivedSnapshots;
+	bool bIsBatchTicked = false;
 };
\ No newline at end of file
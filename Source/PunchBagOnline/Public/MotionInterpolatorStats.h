@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Trace/Trace.h"
+
+/**
+ * Motion interpolator instrumentation: "stat MotionInterp", the MotionInterp CSV category (-csvCategories=MotionInterp)
+ * and the MotionInterp trace channel (-trace=cpu,MotionInterp).
+ * Counters are per frame, the CSV profiler turns them into per second rates.
+ * Counters are only added to on the game thread, parallel tasks report what they did through their results.
+ */
+DECLARE_STATS_GROUP(TEXT("MotionInterp"), STATGROUP_MotionInterp, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batch Tick"), STAT_MotionInterp_BatchTick, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Component Tick"), STAT_MotionInterp_ComponentTick, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lookups"), STAT_MotionInterp_Lookups, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flush Snapshots"), STAT_MotionInterp_FlushSnapshots, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Receive Batch"), STAT_MotionInterp_ReceiveBatch, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode Snapshots"), STAT_MotionInterp_DecodeSnapshots, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Physics Targets"), STAT_MotionInterp_PhysicsTargets, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hit Validation"), STAT_MotionInterp_HitValidation, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Snapshots Sent"), STAT_MotionInterp_SnapshotsSent, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Snapshots Received"), STAT_MotionInterp_SnapshotsReceived, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Batched Snapshots Sent"), STAT_MotionInterp_BatchedSnapshotsSent, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Batched Bits Sent"), STAT_MotionInterp_BatchedBitsSent, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Bits Per Snapshot"), STAT_MotionInterp_BitsPerSnapshot, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Extrapolations"), STAT_MotionInterp_Extrapolations, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Physics Targets Applied"), STAT_MotionInterp_PhysicsTargetsApplied, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Underruns"), STAT_MotionInterp_Underruns, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Stale Epoch Snapshots"), STAT_MotionInterp_StaleEpochSnapshots, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits Validated"), STAT_MotionInterp_HitsValidated, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Dormancy Sleeps"), STAT_MotionInterp_DormancySleeps, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Dormancy Wakes"), STAT_MotionInterp_DormancyWakes, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impacts Sent"), STAT_MotionInterp_ImpactsSent, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impacts Received"), STAT_MotionInterp_ImpactsReceived, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impacts Rejected"), STAT_MotionInterp_ImpactsRejected, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Batched Interpolators"), STAT_MotionInterp_Interpolators, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Network Delay Avg"), STAT_MotionInterp_NetworkDelayAvg, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Network Delay Max"), STAT_MotionInterp_NetworkDelayMax, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Additional Delay Avg"), STAT_MotionInterp_AdditionalDelayAvg, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Buffer Occupancy"), STAT_MotionInterp_BufferOccupancy, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ownership Handoffs"), STAT_MotionInterp_OwnershipHandoffs, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Sleeping Interpolators"), STAT_MotionInterp_SleepingInterpolators, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Last Handoff Release Time"), STAT_MotionInterp_HandoffReleaseTime, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Rewind History"), STAT_MotionInterp_RewindHistoryMemory, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Snapshot Buffers"), STAT_MotionInterp_SnapshotBufferMemory, STATGROUP_MotionInterp, PUNCHBAGONLINE_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(PUNCHBAGONLINE_API, MotionInterp);
+
+UE_TRACE_CHANNEL_EXTERN(MotionInterpChannel, PUNCHBAGONLINE_API);
+
+/** Cycle stat, CSV timing and trace event of one scope */
+#define MOTIONINTERP_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_MotionInterp_##Name); \
+	CSV_SCOPED_TIMING_STAT(MotionInterp, Name); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(MotionInterp_##Name, MotionInterpChannel)
+
+/** Adds to a per frame counter and its CSV stat */
+#define MOTIONINTERP_COUNT(Name, Value) \
+	INC_DWORD_STAT_BY(STAT_MotionInterp_##Name, Value); \
+	CSV_CUSTOM_STAT(MotionInterp, Name, static_cast<int32>(Value), ECsvCustomStatOp::Accumulate)
+
+/** Sets a per frame float stat and its CSV stat */
+#define MOTIONINTERP_SET_FLOAT(Name, Value) \
+	SET_FLOAT_STAT(STAT_MotionInterp_##Name, Value); \
+	CSV_CUSTOM_STAT(MotionInterp, Name, static_cast<float>(Value), ECsvCustomStatOp::Set)
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MotionInterpolatorComponent.h"
+#include "MotionClockSync.h"
+#include "MotionSnapshotRecording.h"
+#include "MotionInterpolationBatch.h"
+#include "MotionRewindHistory.h"
+#include "MotionSnapshotCodec.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Queue.h"
+#include "MotionInterpolatorSubsystem.generated.h"
+
+class UMotionInterpolatorSubsystem;
+class UMotionSyncChannelComponent;
+struct FBodyInstance;
+
+/** Interpolated state of one body, written to the physics scene with the next flush */
+struct FMotionPhysicsTarget
+{
+	FBodyInstance* BodyInstance = nullptr;
+	FTransform Transform;
+	FVector Velocity = FVector::ZeroVector;
+	/** Degrees per second */
+	FVector AngularVelocity = FVector::ZeroVector;
+};
+
+/** One received entry, resolved against its channel's history on the game thread and dequantized by a decode task */
+struct FMotionSnapshotDecode
+{
+	/** Only its received queue is touched off the game thread */
+	UMotionInterpolatorComponent* Interpolator = nullptr;
+	TWeakObjectPtr<UMotionInterpolatorComponent> WeakInterpolator;
+	FQuantizedMotionSnapshot Quantized;
+	FMotionSnapshotPrecision Precision;
+	uint16 AuthorityEpoch = 0;
+};
+
+/** Entries of one received batch, see UMotionInterpolatorSubsystem::DecodeReceivedSnapshots */
+struct FMotionSnapshotDecodeBatch
+{
+	TArray<FMotionSnapshotDecode> Decodes;
+	TWeakObjectPtr<UMotionSyncChannelComponent> SourceChannel;
+	/** Synced time the packet arrived */
+	double ArrivalTime = 0.0;
+};
+
+UENUM(BlueprintType)
+enum class EMotionHitValidation : uint8
+{
+	/** The striker was within Radius + Tolerance of the struck collision at the rewound times */
+	Hit,
+	Miss,
+	/** A query time is outside the rewind history, too old or not received yet */
+	OutOfHistory,
+	/** Missing interpolators, synced components or histories */
+	Invalid
+};
+
+/** A strike to validate at the times the striking client saw it, see UMotionInterpolatorSubsystem::ValidateHits */
+USTRUCT(BlueprintType)
+struct FMotionHitQuery
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** Interpolator of the striking hand, glove or tool */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	UMotionInterpolatorComponent* Striker = nullptr;
+	/** Sync target of the striker, INDEX_NONE for its synced component */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	int32 StrikerTargetIndex = INDEX_NONE;
+	/** Contact point relative to the striker, like the center of a fist */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FVector StrikerOffset = FVector::ZeroVector;
+	/** Synced time of the strike on the striker's timeline, the client's send time for its own hands. Not Blueprint visible, floats lose milliseconds after a few hours */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	double StrikerTime = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	UMotionInterpolatorComponent* Struck = nullptr;
+	/** Synced time of the struck pose the client saw, its lookup time there */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	double StruckTime = 0.0;
+	/** Radius of the striker around the contact point */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	float Radius = 0.0f;
+	/** Allowed gap between the striker and the struck collision, covers quantization and sampling */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	float Tolerance = 5.0f;
+};
+
+USTRUCT(BlueprintType)
+struct FMotionHitResult
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	EMotionHitValidation Validation = EMotionHitValidation::Invalid;
+	/** Gap between the striker's surface and the struck collision, negative when they overlap */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	float Distance = 0.0f;
+	/** Closest point of the struck collision, at its current pose */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MotionInterpolator")
+	FVector Location = FVector::ZeroVector;
+};
+
+USTRUCT()
+struct FMotionInterpolatorBatchTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	UMotionInterpolatorSubsystem* Subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FMotionInterpolatorBatchTickFunction> : public TStructOpsTypeTraitsBase2<FMotionInterpolatorBatchTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Ticks every batched UMotionInterpolatorComponent of the world in a single pass.
+ * Synced time is resolved once per frame, snapshot lookups run in parallel and the results are applied on the game thread.
+ * Also routes batched snapshots between UMotionSyncChannelComponents and interpolators by their compact net ids.
+ * On the server, snapshots are only forwarded to connections with an interest point (pawn or view) within InterestRadius,
+ * found through a grid of InterestRadius sized cells rebuilt once per frame.
+ * Owns the synchronized clock: the server clock starts with the world, clients estimate it through their local channel.
+ */
+UCLASS(Config = Game)
+class PUNCHBAGONLINE_API UMotionInterpolatorSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Synchronized time, the same on every machine. Resolved once per frame and never goes back by less than a clock step */
+	double GetSyncedTime() const;
+	/** GetSyncedTime of the world's subsystem, 0 without one */
+	static double GetWorldSyncedTime(const UWorld* World);
+	/** Uncached monotonic clock of this machine, the server clock on the server */
+	double GetLocalClockTime() const;
+	/** Uncached synchronized time of a FPlatformTime::Seconds() reading, like the receive time of a packet */
+	double GetSyncedTimeAt(double PlatformTime) const;
+	/**
+	 * Synced time the connection read the packet being processed through Map. The net driver stamps it in TickDispatch on the game thread,
+	 * right before the packet's bunches are handled, so it is when the frame picked the packet up rather than when the socket got it.
+	 * The current synced time without a connection
+	 */
+	static double GetPacketArrivalTime(class UPackageMap* Map);
+	/** Whether this machine's clock is the server clock */
+	bool IsClockAuthority() const;
+	/** Whether synced times are on the server clock, clients fall back to the game state's server time until their first clock sync */
+	bool IsClockSynchronized() const { return IsClockAuthority() || ClockSync.IsSynchronized(); }
+	FMotionClockSync& GetClockSync() { return ClockSync; }
+	/** Drives the clock by hand instead of the platform clock, so replays are deterministic and can run faster than real time */
+	void SetManualClockTime(double Time);
+	void ClearManualClock();
+
+	/** Records every snapshot added to or sent by an interpolator of this world, see FMotionSnapshotRecorder */
+	bool StartRecording(const FString& Filename);
+	void StopRecording();
+	/** Null when not recording */
+	FMotionSnapshotRecorder* GetRecorder() { return Recorder.IsOpen() ? &Recorder : nullptr; }
+
+	void RegisterInterpolator(UMotionInterpolatorComponent* Interpolator);
+	void UnregisterInterpolator(UMotionInterpolatorComponent* Interpolator);
+	/** EMotionInterpolatorTickMode::PerComponent interpolators tick before the batch tick, which flushes their physics targets with the batched ones */
+	void RegisterComponentTick(UMotionInterpolatorComponent* Interpolator);
+	void UnregisterComponentTick(UMotionInterpolatorComponent* Interpolator);
+
+	void TickInterpolators(float DeltaTime);
+
+	/** Queues a body target of an EMotionApplyMode::PhysicsTarget interpolator, the body must stay alive until the next flush */
+	void QueuePhysicsTarget(FBodyInstance& BodyInstance, const FTransform& Transform, const FVector& Velocity, const FVector& AngularVelocity);
+	/** Writes every queued target under a single physics scene lock */
+	void FlushPhysicsTargets();
+
+	/** Server: adds a world space pose, synced component first, to the interpolator's rewind history */
+	void RecordRewindPose(const UMotionInterpolatorComponent* Interpolator, double Time, TArrayView<const FMotionSnapshotTransform> Transforms);
+	void RemoveRewindHistory(const UMotionInterpolatorComponent* Interpolator);
+	const FMotionRewindHistory* FindRewindHistory(const UMotionInterpolatorComponent* Interpolator) const;
+
+	/** Server: world transform of the synced component, or of the sync target at TargetIndex, at a past synced time */
+	bool GetRewoundTransform(const UMotionInterpolatorComponent* Interpolator, int32 TargetIndex, double Time, FTransform& OutTransform) const;
+
+	/**
+	 * Server: checks strikes against the rewound poses of both sides, OutResults gets one result per query.
+	 * The struck collision isn't moved back, the rewound contact point is moved into its current pose instead.
+	 */
+	void ValidateHits(TArrayView<const FMotionHitQuery> Queries, TArray<FMotionHitResult>& OutResults) const;
+	UFUNCTION(BlueprintCallable, Category = "MotionInterpolator|Rewind")
+	FMotionHitResult ValidateHit(const FMotionHitQuery& Query) const;
+
+	/** Server: allocates a new net id. Client: registers the replicated one. Returns the registered id */
+	uint16 RegisterNetId(UMotionInterpolatorComponent* Interpolator, uint16 NetId = 0);
+	void UnregisterNetId(uint16 NetId);
+	UMotionInterpolatorComponent* FindInterpolatorByNetId(uint16 NetId) const;
+
+	void RegisterChannel(UMotionSyncChannelComponent* Channel);
+	void UnregisterChannel(UMotionSyncChannelComponent* Channel);
+	/** Client side channel of the local player, null on the server */
+	UMotionSyncChannelComponent* GetLocalChannel() const;
+	/** Server side channel of a remote connection */
+	UMotionSyncChannelComponent* FindChannelByConnection(const class UNetConnection* Connection) const;
+
+	/**
+	 * Server: queues the snapshot to every interested remote channel except the one it came from.
+	 * Connections without a channel get it through the interpolator's multicast, which the sender with SenderGuid ignores
+	 */
+	void ForwardSnapshot(uint16 NetId, const FMotionSnapshot& Snapshot, const UMotionSyncChannelComponent* SourceChannel, const FGuid& SenderGuid = FGuid());
+	/** Server: sends the impact right away to every interested remote channel except the one it came from, multicasts like ForwardSnapshot */
+	void ForwardImpact(uint16 NetId, const FMotionImpactEvent& Impact, const UMotionSyncChannelComponent* SourceChannel, const FGuid& SenderGuid = FGuid());
+	/** Server: whether a client connection has no remote channel (yet), so batches don't reach it */
+	bool HasConnectionsWithoutChannel();
+
+	/**
+	 * Dequantizes received snapshots on a worker thread and queues them to their interpolators, which get them with the next drain.
+	 * Tasks of one channel run in order, InOutChannelTask is the channel's latest one.
+	 */
+	void DecodeReceivedSnapshots(FMotionSnapshotDecodeBatch&& Batch, FGraphEventRef& InOutChannelTask);
+	/** Blocks until every decode task is done, for teardown. Drains don't wait, they take what finished and leave the rest to the next one */
+	void WaitForSnapshotDecodes();
+	/** Hands every decoded snapshot to its interpolator: authority checks and forwarding on the server, then ReceiveSnapshot */
+	void DrainReceivedSnapshots();
+
+	/** Channels report what they put on the wire, published as stats with the next batch tick */
+	void RecordSentSnapshots(int32 NumSnapshots, int32 NumBits);
+
+	/** Lookups are done on the game thread when there are fewer interpolators than this */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator")
+	int32 MinParallelLookups = 16;
+
+	/** Dequantizes received batches off the game thread, see DecodeReceivedSnapshots */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator")
+	bool bDecodeSnapshotsAsync = true;
+	/** Smaller batches are decoded right away, a task would cost more than it saves */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator", meta = (EditCondition = "bDecodeSnapshotsAsync"))
+	int32 MinAsyncDecodes = 8;
+
+	/** Interpolates all lookups between two snapshots in one vectorized pass, see FMotionInterpolationBatch */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator")
+	bool bUseInterpolationBatch = true;
+
+	/** When disabled, every snapshot is forwarded to every remote connection */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator")
+	bool bUseInterestManagement = true;
+
+	/** Snapshots farther than this from all interest points of a connection are not forwarded to it */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator", meta = (EditCondition = "bUseInterestManagement"))
+	float InterestRadius = 5000.0f;
+
+	/** Server: keeps a FMotionRewindHistory of every interpolator, so hits can be validated at the time the client saw them */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator|Rewind")
+	bool bRecordRewindHistory = true;
+	/** Seconds of history, should cover the highest round trip plus playout delay that hits are accepted with */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator|Rewind", meta = (EditCondition = "bRecordRewindHistory"))
+	float RewindHistoryDuration = 0.5f;
+	/** Highest rate poses are recorded at, each interpolator keeps Duration * Rate samples of 1 + sync targets transforms */
+	UPROPERTY(Config, EditAnywhere, Category = "MotionInterpolator|Rewind", meta = (EditCondition = "bRecordRewindHistory", ClampMin = "1.0"))
+	float RewindSampleRate = 60.0f;
+
+private:
+	void RegisterBatchTick();
+	/** The game state's server time estimate at a local clock time, moved onto the synced timeline by APBOGameState::GetSyncedClockOffset */
+	double GetUnsynchronizedTime(double LocalTime) const;
+	void UpdateInterestGrid();
+	/** Fills ForwardTargets with the remote channels interested in Location, except SourceChannel */
+	void GatherForwardTargets(const FVector& Location, const UMotionSyncChannelComponent* SourceChannel);
+	/** Any thread */
+	void DecodeSnapshots(const FMotionSnapshotDecodeBatch& Batch);
+	void DeliverSnapshot(UMotionInterpolatorComponent& Interpolator, const FMotionSnapshot& Snapshot, UMotionSyncChannelComponent* SourceChannel);
+	FIntVector GetInterestCell(const FVector& Location) const;
+
+	UPROPERTY(Transient)
+	TArray<UMotionInterpolatorComponent*> Interpolators;
+
+	TArray<UMotionInterpolatorComponent*> TickedInterpolators;
+	TArray<FMotionInterpolatorTickContext> TickContexts;
+	FMotionInterpolationBatch InterpolationBatch;
+
+	FMotionInterpolatorBatchTickFunction BatchTickFunction;
+
+	TArray<FMotionPhysicsTarget> PendingPhysicsTargets;
+
+	FGraphEventArray PendingDecodeTasks;
+	/** Interpolators with decoded snapshots, queued by whoever decoded their first one since the last drain */
+	TQueue<TWeakObjectPtr<UMotionInterpolatorComponent>, EQueueMode::Mpsc> PendingReceivers;
+
+	TMap<const UMotionInterpolatorComponent*, FMotionRewindHistory> RewindHistories;
+
+	TMap<uint16, TWeakObjectPtr<UMotionInterpolatorComponent>> NetIdToInterpolator;
+	uint16 LastNetId = 0;
+
+	UPROPERTY(Transient)
+	TArray<UMotionSyncChannelComponent*> Channels;
+
+	TMap<FIntVector, TArray<UMotionSyncChannelComponent*, TInlineAllocator<4>>> InterestGrid;
+	uint64 InterestGridFrame = MAX_uint64;
+	TArray<UMotionSyncChannelComponent*> ForwardTargets;
+
+	uint64 ChannelCoverageFrame = MAX_uint64;
+	bool bHasConnectionsWithoutChannel = false;
+
+	FMotionClockSync ClockSync;
+	double ClockEpoch = 0.0;
+	mutable double CachedSyncedTime = 0.0;
+	mutable uint64 SyncedTimeFrame = MAX_uint64;
+
+	bool bUseManualClock = false;
+	double ManualClockTime = 0.0;
+
+	FMotionSnapshotRecorder Recorder;
+
+	int32 SentSnapshotsSinceTick = 0;
+	int64 SentBitsSinceTick = 0;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Streaming estimate of one-way delay and jitter of the snapshots of one stream arriving through one connection, O(1) per sample.
+ * Jitter follows RFC 3550: J += (|D| - J) / 16, D being the transit time difference of two consecutive arrivals.
+ * Streams sent at different rates or sampled at different points of their frame have different transit baselines,
+ * so mixing them would count the difference as jitter.
+ */
+struct FMotionJitterEstimator
+{
+public:
+	/** Enough to cover almost every late arrival of a roughly normal jitter */
+	static constexpr float DefaultJitterMultiplier = 3.0f;
+
+	void AddSample(double Timestamp, double ArrivalTime)
+	{
+		const float Transit = static_cast<float>(ArrivalTime - Timestamp);
+		if (NumSamples == 0)
+		{
+			SmoothedTransit = Transit;
+			Jitter = 0.0f;
+		}
+		else
+		{
+			Jitter += (FMath::Abs(Transit - LastTransit) - Jitter) * JitterGain;
+			SmoothedTransit += (Transit - SmoothedTransit) * TransitGain;
+		}
+		LastTransit = Transit;
+		++NumSamples;
+	}
+
+	void Reset()
+	{
+		*this = FMotionJitterEstimator();
+	}
+
+	float GetTransit() const { return SmoothedTransit; }
+	float GetJitter() const { return Jitter; }
+	int32 GetNumSamples() const { return NumSamples; }
+
+	/** Delay that lets a stream sending every SnapshotInterval be interpolated without running out of snapshots */
+	float GetPlayoutDelay(float SnapshotInterval, float JitterMultiplier) const
+	{
+		return FMath::Max(SmoothedTransit, 0.0f) + SnapshotInterval + Jitter * JitterMultiplier;
+	}
+
+private:
+	static constexpr float JitterGain = 1.0f / 16.0f;
+	static constexpr float TransitGain = 1.0f / 16.0f;
+
+	float SmoothedTransit = 0.0f;
+	float Jitter = 0.0f;
+	float LastTransit = 0.0f;
+	int32 NumSamples = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MotionInterpolatorComponent.h"
+
+/**
+ * Fixed size history of world space poses of one interpolator on the snapshot timeline: the synced component first, then its sync targets.
+ * Samples closer than the minimum interval to the newest one are skipped, so the covered time doesn't shrink at high tick or send rates.
+ * Memory is allocated once in Initialize, lookups are a binary search over the sample times.
+ */
+class PUNCHBAGONLINE_API FMotionRewindHistory
+{
+public:
+	/** Clears the history when the layout changes */
+	void Initialize(int32 InNumTransforms, int32 InCapacity, float InMinSampleInterval);
+	void Reset();
+
+	/** Adds a pose newer than every recorded one, missing transforms are taken from the synced component */
+	void Record(double Time, TArrayView<const FMotionSnapshotTransform> Transforms);
+
+	/**
+	 * Pose of one transform at Time, interpolated between the two closest samples.
+	 * Times up to one sample interval past the newest sample get the newest pose, any later time with bHoldNewest.
+	 * False outside the recorded window.
+	 */
+	bool Sample(int32 TransformIndex, double Time, FTransform& OutTransform, bool bHoldNewest = false) const;
+
+	int32 Num() const { return Count; }
+	int32 GetNumTransforms() const { return NumTransforms; }
+	int32 Capacity() const { return Times.Num(); }
+	double GetOldestTime() const { return Count > 0 ? GetTime(0) : 0.0; }
+	double GetNewestTime() const { return Count > 0 ? GetTime(Count - 1) : 0.0; }
+	SIZE_T GetAllocatedSize() const { return Times.GetAllocatedSize() + Poses.GetAllocatedSize(); }
+
+private:
+	FORCEINLINE int32 GetSlot(int32 Index) const { return (Head + Index) % Times.Num(); }
+	FORCEINLINE double GetTime(int32 Index) const { return Times[GetSlot(Index)]; }
+	FORCEINLINE const FMotionSnapshotTransform& GetPose(int32 Index, int32 TransformIndex) const { return Poses[GetSlot(Index) * NumTransforms + TransformIndex]; }
+
+	/** Index of the first sample with a time > Time, Num() if there is none */
+	int32 UpperBound(double Time) const;
+
+	TArray<double> Times;
+	/** NumTransforms per slot */
+	TArray<FMotionSnapshotTransform> Poses;
+	int32 Head = 0;
+	int32 Count = 0;
+	int32 NumTransforms = 0;
+	float MinSampleInterval = 0.0f;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16.h"
+#include "SnapshotRingBuffer.h"
+
+struct FMotionSnapshot;
+struct FMotionSnapshotTransform;
+
+/**
+ * Buffered snapshot packed in one cache line: half precision velocities and no allocation of its own.
+ * The fields take 53 bytes, the timestamp being an absolute double in synced time. Aligned to the line,
+ * so an entry is PLATFORM_CACHE_LINE_SIZE (64) bytes and a lookup touches a single line, the rest is padding.
+ * Sync target transforms live in the target pool of the owning FMotionSnapshotBuffer.
+ */
+struct alignas(PLATFORM_CACHE_LINE_SIZE) FMotionBufferedSnapshot
+{
+	FVector Location;
+	/** Kept as Euler angles, the interpolation and the batch kernel work on them */
+	FRotator Rotation;
+	FFloat16 Velocity[3];
+	/** Degrees per second */
+	FFloat16 AngularVelocity[3];
+	double Timestamp = 0.0;
+	/** Block of the target pool, INDEX_NONE without sync targets */
+	int32 TargetBlock = INDEX_NONE;
+	uint8 NumTargets = 0;
+
+	FVector GetVelocity() const { return FVector(Velocity[0].GetFloat(), Velocity[1].GetFloat(), Velocity[2].GetFloat()); }
+	FVector GetAngularVelocity() const { return FVector(AngularVelocity[0].GetFloat(), AngularVelocity[1].GetFloat(), AngularVelocity[2].GetFloat()); }
+};
+
+static_assert(sizeof(FMotionBufferedSnapshot) == PLATFORM_CACHE_LINE_SIZE, "Buffered snapshots should take exactly one cache line");
+static_assert(alignof(FMotionBufferedSnapshot) == PLATFORM_CACHE_LINE_SIZE, "Buffered snapshots should start on a cache line");
+
+/**
+ * Snapshot buffer of one interpolator: packed entries kept sorted by TSnapshotRingBuffer, and one pool for their sync targets.
+ * The pool has a block per entry plus one, so adding never allocates once the widest snapshot has been seen.
+ * Reads are indexed, entries and target views point into the buffer and are valid until it changes.
+ * Arrival times and authority epochs are only needed on receive and aren't kept.
+ */
+class PUNCHBAGONLINE_API FMotionSnapshotBuffer
+{
+public:
+	/** Changes the capacity, keeping the newest snapshots */
+	void SetCapacity(int32 InCapacity);
+	/** See TSnapshotRingBuffer::Add */
+	bool Add(const FMotionSnapshot& Snapshot);
+	void Empty();
+	/** Drops every snapshot with Timestamp >= Time */
+	void RemoveFrom(double Time);
+
+	FORCEINLINE int32 Num() const { return Entries.Num(); }
+	FORCEINLINE bool IsEmpty() const { return Entries.IsEmpty(); }
+	FORCEINLINE int32 Capacity() const { return Entries.Capacity(); }
+	/** Index of the first snapshot with Timestamp > Time, Num() if there is none */
+	FORCEINLINE int32 UpperBound(double Time) const { return Entries.UpperBound(Time); }
+
+	/** Entry by logical index, 0 is the oldest one */
+	FORCEINLINE const FMotionBufferedSnapshot& GetEntry(int32 Index) const { return Entries[Index]; }
+	FORCEINLINE double GetTimestamp(int32 Index) const { return Entries[Index].Timestamp; }
+	FORCEINLINE double GetFirstTimestamp() const { return Entries.First().Timestamp; }
+	FORCEINLINE double GetLastTimestamp() const { return Entries.Last().Timestamp; }
+	TArrayView<const FMotionSnapshotTransform> GetTargets(int32 Index) const;
+
+	/** Unpacks one snapshot, sync targets included */
+	void GetSnapshot(int32 Index, FMotionSnapshot& OutSnapshot) const;
+	FMotionSnapshot GetSnapshot(int32 Index) const;
+	FMotionSnapshot GetLast() const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** Grows the pool, blocks keep their index */
+	void ReserveTargetBlocks(int32 NumBlocks, int32 Stride);
+	void FreeTargetBlock(int32 Block);
+
+	TSnapshotRingBuffer<FMotionBufferedSnapshot, TAlignedHeapAllocator<PLATFORM_CACHE_LINE_SIZE>> Entries;
+	TArray<FMotionSnapshotTransform> TargetPool;
+	TArray<int32> FreeTargetBlocks;
+	int32 NumTargetBlocks = 0;
+	/** Transforms per block, the most sync targets of any added snapshot */
+	int32 TargetStride = 0;
+};
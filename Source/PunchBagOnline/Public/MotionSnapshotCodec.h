@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MotionInterpolatorComponent.h"
+
+/** Number of recent snapshots per stream kept to resolve acked baselines */
+static constexpr int32 MotionSnapshotStreamHistory = 32;
+
+/** Sync target transform quantized with its FMotionTransformPrecision */
+struct PUNCHBAGONLINE_API FQuantizedMotionTransform
+{
+	FIntVector Location = FIntVector::ZeroValue;
+	FIntVector Rotation = FIntVector::ZeroValue;
+	int32 RotationLargest = 3;
+};
+
+/**
+ * FMotionSnapshotSample quantized with the precision of its snapshot.
+ * Relative to the next newer sample, or to the snapshot for the newest one, so a sampled arc costs a few bits per axis.
+ */
+struct PUNCHBAGONLINE_API FQuantizedMotionSample
+{
+	/** FMotionSnapshotPrecision::Location steps */
+	FIntVector Location = FIntVector::ZeroValue;
+	/** Relative if RotationLargest is the one of the reference, absolute otherwise */
+	FIntVector Rotation = FIntVector::ZeroValue;
+	int32 RotationLargest = 3;
+	/** Milliseconds before the reference */
+	int32 Age = 0;
+	/** One per sync target of the snapshot, relative to the reference's transforms like the rotation */
+	TArray<FQuantizedMotionTransform> Transforms;
+};
+
+/**
+ * FMotionSnapshot quantized to the precision it is sent with.
+ * Sender and receiver hold bit-identical copies, so it can be used as a baseline for delta encoding.
+ */
+struct PUNCHBAGONLINE_API FQuantizedMotionSnapshot
+{
+	/** FMotionSnapshotPrecision::Location steps */
+	FIntVector Location = FIntVector::ZeroValue;
+	/** Smallest three quaternion components, in FMotionSnapshotPrecision::RotationBits */
+	FIntVector Rotation = FIntVector::ZeroValue;
+	/** Index of the dropped largest quaternion component */
+	int32 RotationLargest = 3;
+	/** FMotionSnapshotPrecision::Velocity steps */
+	FIntVector Velocity = FIntVector::ZeroValue;
+	/** FMotionSnapshotPrecision::AngularVelocity steps */
+	FIntVector AngularVelocity = FIntVector::ZeroValue;
+	/** Milliseconds */
+	int32 Timestamp = 0;
+	/** One per sync target */
+	TArray<FQuantizedMotionTransform> Transforms;
+	/** Oldest first, never delta encoded against the baseline */
+	TArray<FQuantizedMotionSample> Samples;
+
+	static FQuantizedMotionSnapshot Quantize(const FMotionSnapshot& Snapshot, const FMotionSnapshotPrecision& Precision);
+	FMotionSnapshot Dequantize(const FMotionSnapshotPrecision& Precision) const;
+
+	/**
+	 * Difference from the baseline. Rotations stay absolute if the largest quaternion component changed,
+	 * transforms stay absolute if the baseline has a different number of them
+	 */
+	FQuantizedMotionSnapshot MakeDelta(const FQuantizedMotionSnapshot& Baseline) const;
+	/** Inverse of MakeDelta */
+	FQuantizedMotionSnapshot ApplyDelta(const FQuantizedMotionSnapshot& Baseline) const;
+
+	/** Writes every field as zigzag ints packed to the bit width of the largest one, so small deltas are cheap */
+	void Serialize(FArchive& Ar);
+};
+
+/** Quaternion "smallest three" encoding: the largest component is dropped and rebuilt from the unit length */
+struct PUNCHBAGONLINE_API FSmallestThreeQuat
+{
+	static void Quantize(const FQuat& Quat, int32 Bits, FIntVector& OutComponents, int32& OutLargest);
+	static FQuat Dequantize(const FIntVector& Components, int32 Largest, int32 Bits);
+	/** Fixed size 2 + 3 * Bits serialization */
+	static void Serialize(FArchive& Ar, FQuat& Quat, int32 Bits);
+};
+
+/** Sequence numbers wrap around, a is newer than b if it is less than half the range ahead */
+FORCEINLINE bool IsMotionSequenceNewer(uint16 A, uint16 B)
+{
+	return static_cast<int16>(A - B) > 0;
+}
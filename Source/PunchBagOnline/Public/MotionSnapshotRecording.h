@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MotionInterpolatorComponent.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+enum class EMotionSnapshotRecordKind : uint8
+{
+	/** Added to the interpolator buffer, from the network or AddSnapshot */
+	Received,
+	/** Sent by the authority */
+	Sent,
+	/** Applied to the synced component, written by replays */
+	Applied,
+	/** Starts a session, written whenever a recorder opens the file. Synced times restart with each session */
+	Session
+};
+
+/**
+ * One fixed size record. Recordings are a FMotionSnapshotRecordingHeader followed by records only,
+ * so they can be appended to while running and memory mapped as a plain array. Little endian.
+ * Records hold the dequantized pose of the synced component, not the wire payload: sync targets, sent samples
+ * and the delta encoding aren't recorded, so replays cover buffering and interpolation but not the codec.
+ */
+struct FMotionSnapshotRecord
+{
+	/** CRC of the interpolator path name, stable across sessions for placed actors */
+	uint32 StreamId = 0;
+	uint8 Kind = 0;
+	uint8 Reserved[3] = {};
+	double Timestamp = 0.0;
+	double ArrivalTime = 0.0;
+	float Location[3] = {};
+	float Rotation[3] = {};
+	float Velocity[3] = {};
+	float AngularVelocity[3] = {};
+
+	static FMotionSnapshotRecord Make(uint32 StreamId, EMotionSnapshotRecordKind Kind, const FMotionSnapshot& Snapshot);
+	FMotionSnapshot ToSnapshot() const;
+	EMotionSnapshotRecordKind GetKind() const { return static_cast<EMotionSnapshotRecordKind>(Kind); }
+};
+static_assert(sizeof(FMotionSnapshotRecord) == 72, "Recordings are memory mapped, the record layout must not change");
+
+struct FMotionSnapshotRecordingHeader
+{
+	static constexpr uint32 ExpectedMagic = 0x4353524D; // "MRSC"
+	/** 2: double timestamps, 3: session records */
+	static constexpr uint32 CurrentVersion = 3;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = CurrentVersion;
+	uint32 RecordSize = sizeof(FMotionSnapshotRecord);
+	uint32 Reserved = 0;
+
+	bool IsValid() const { return Magic == ExpectedMagic && Version == CurrentVersion && RecordSize == sizeof(FMotionSnapshotRecord); }
+};
+static_assert(sizeof(FMotionSnapshotRecordingHeader) == 16, "Recordings are memory mapped, the header layout must not change");
+
+/** Appends snapshot records to a recording file */
+class PUNCHBAGONLINE_API FMotionSnapshotRecorder
+{
+public:
+	~FMotionSnapshotRecorder();
+
+	/** Appends a new session to an existing recording, returns false if the file can't be written or isn't a recording */
+	bool Open(const FString& InFilename);
+	/** Writes a session record, the times of the records after it are on a new timeline */
+	void BeginSession();
+	void Close();
+	bool IsOpen() const { return Writer != nullptr; }
+	const FString& GetFilename() const { return Filename; }
+	int64 GetNumRecords() const { return NumRecords; }
+
+	void Record(uint32 StreamId, EMotionSnapshotRecordKind Kind, const FMotionSnapshot& Snapshot);
+
+	static uint32 GetStreamId(const UMotionInterpolatorComponent& Interpolator);
+
+private:
+	TUniquePtr<FArchive> Writer;
+	FString Filename;
+	int64 NumRecords = 0;
+};
+
+/** Memory maps a recording, falls back to loading it when mapping isn't supported */
+class PUNCHBAGONLINE_API FMotionSnapshotRecordingReader
+{
+public:
+	~FMotionSnapshotRecordingReader();
+
+	bool Open(const FString& Filename);
+	TArrayView<const FMotionSnapshotRecord> GetRecords() const { return Records; }
+	/** Records of each non-empty session without the session records, in the order they were recorded */
+	const TArray<TArrayView<const FMotionSnapshotRecord>>& GetSessions() const { return Sessions; }
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedData;
+	TArrayView<const FMotionSnapshotRecord> Records;
+	TArray<TArrayView<const FMotionSnapshotRecord>> Sessions;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MotionSnapshotReplayCommandlet.generated.h"
+
+/**
+ * Replays the received snapshots of a recording (see MotionInterp.Record) into fresh interpolators, as fast as possible.
+ * The subsystem clock is driven by hand at a fixed tick rate, so a replay is deterministic for a given build.
+ * Applied states are written to an output recording and can be compared against the output of another build.
+ * Each recorded session is replayed in a world of its own, since its clock starts over. -Session=<index> replays a single one.
+ *
+ * UE4Editor-Cmd PunchBagOnline -run=MotionSnapshotReplay -nullrhi -unattended
+ *     -Input=<recording>.msr -Output=<output>.msr -Reference=<output of another build>.msr -Tolerance=0.01 -TickRate=60 -Interpolation=Hermite -Session=0
+ */
+UCLASS()
+class UMotionSnapshotReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMotionSnapshotReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
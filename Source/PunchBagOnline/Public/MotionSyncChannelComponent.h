@@ -0,0 +1,248 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "MotionInterpolatorComponent.h"
+#include "MotionSnapshotCodec.h"
+#include "MotionJitterEstimator.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "MotionSyncChannelComponent.generated.h"
+
+USTRUCT()
+struct FMotionSnapshotBatchEntry
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** Compact id of the receiving UMotionInterpolatorComponent, see UMotionInterpolatorComponent::GetSyncNetId */
+	uint16 NetId = 0;
+
+	/** Per channel and net id sequence, used for acks and baselines */
+	uint16 Sequence = 0;
+
+	/** Sequence of the acked snapshot the payload is a delta from, equal to Sequence for full snapshots */
+	uint16 BaselineSequence = 0;
+
+	/** Authority epoch of the sender, not delta encoded since it rarely changes and must never be lost to a missing baseline */
+	uint16 AuthorityEpoch = 0;
+
+	/** What goes over the wire, absolute values or deltas from the baseline */
+	FQuantizedMotionSnapshot Payload;
+
+	/** Resolved snapshot, not serialized */
+	FMotionSnapshot Snapshot;
+
+	bool IsDelta() const { return Sequence != BaselineSequence; }
+
+	/** Wire format of one entry, shared by the batch serializer and the bandwidth scheduler */
+	void Serialize(FArchive& Ar);
+};
+
+/** Receiver confirmation of the newest snapshot of a stream, which the sender can then use as a baseline */
+USTRUCT()
+struct FMotionSnapshotAck
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	uint16 NetId = 0;
+	uint16 Sequence = 0;
+};
+
+/** All snapshots sent to one connection during one frame, packed into a single RPC */
+USTRUCT()
+struct FMotionSnapshotBatch
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	TArray<FMotionSnapshotBatchEntry> Entries;
+	TArray<FMotionSnapshotAck> Acks;
+
+	/** Synced time the packet carrying the batch was received, not serialized */
+	double ArrivalTime = 0.0;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FMotionSnapshotBatch> : public TStructOpsTypeTraitsBase2<FMotionSnapshotBatch>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/** Sender side state of one net id on one channel */
+struct FMotionSnapshotSendStream
+{
+	uint16 NextSequence = 0;
+	bool bHasAckedBaseline = false;
+	uint16 AckedSequence = 0;
+	FQuantizedMotionSnapshot AckedBaseline;
+
+	uint16 HistorySequences[MotionSnapshotStreamHistory] = {};
+	FQuantizedMotionSnapshot History[MotionSnapshotStreamHistory];
+
+	/** Fills OutEntry with the next sequence, delta encoded from the acked baseline while the receiver still has it */
+	void Encode(uint16 NetId, const FQuantizedMotionSnapshot& Quantized, uint16 AuthorityEpoch, bool bUseDelta, FMotionSnapshotBatchEntry& OutEntry);
+	/** Makes an acked snapshot the baseline, stale acks and ones gone from the history are ignored */
+	void Ack(uint16 Sequence);
+};
+
+/** Receiver side state of one net id on one channel */
+struct FMotionSnapshotReceiveStream
+{
+	bool bHasLatest = false;
+	uint16 LatestSequence = 0;
+
+	bool HistoryValid[MotionSnapshotStreamHistory] = {};
+	uint16 HistorySequences[MotionSnapshotStreamHistory] = {};
+	FQuantizedMotionSnapshot History[MotionSnapshotStreamHistory];
+
+	/**
+	 * Resolves deltas against the history and adds the entry to it, returns false if the baseline is gone.
+	 * bOutIsLatest is set when the entry is the newest of the stream, the one to ack.
+	 */
+	bool Decode(const FMotionSnapshotBatchEntry& Entry, FQuantizedMotionSnapshot& OutQuantized, bool& bOutIsLatest);
+};
+
+/**
+ * Per-connection snapshot channel living on the PlayerController.
+ * Collects every snapshot sent through the connection during a frame and flushes them as batches,
+ * instead of one RPC per interpolator per send.
+ * Snapshots are delta encoded from the newest one the other side has acked, and sent in full when there is no recent ack.
+ * Only the newest snapshot per interpolator is kept, sampled ones take the poses they replace along. Each one accumulates priority from its sync period hint,
+ * motion and distance to the viewer, and the highest ones are sent within the connection's byte budget.
+ * The client side channel also runs the clock sync exchanges of UMotionInterpolatorSubsystem.
+ */
+UCLASS(ClassGroup=(Custom))
+class PUNCHBAGONLINE_API UMotionSyncChannelComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UMotionSyncChannelComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	void QueueSnapshot(uint16 NetId, const FMotionSnapshot& Snapshot);
+
+	/** Server side channel of a remote client */
+	bool IsRemoteChannel() const;
+	/** Client side channel of the local player */
+	bool IsLocalChannel() const;
+
+	class UNetConnection* GetNetConnection() const;
+
+	/** Refreshes the locations this connection cares about: its pawn and its view point (HMD) */
+	void UpdateInterestPoints();
+	const TArray<FVector, TInlineAllocator<2>>& GetInterestPoints() const { return InterestPoints; }
+	/** Distance from the closest interest point, MAX_flt if there is none */
+	float GetInterestDistance(const FVector& Location) const;
+
+	/** Delay and jitter of the snapshots of one net id received through this connection */
+	FMotionJitterEstimator& GetJitterEstimator(uint16 NetId) { return JitterEstimators.FindOrAdd(NetId); }
+	float GetPlayoutDelay(uint16 NetId, float SnapshotInterval) const;
+
+	UFUNCTION(Server, Unreliable)
+	void ServerReceiveSnapshotBatch(const FMotionSnapshotBatch& Batch);
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveSnapshotBatch(const FMotionSnapshotBatch& Batch);
+
+	/** Impacts are rare and their swing isn't streamed at a high rate, so they are reliable */
+	UFUNCTION(Server, Reliable)
+	void ServerReceiveImpact(uint16 NetId, const FMotionImpactEvent& Impact);
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveImpact(uint16 NetId, const FMotionImpactEvent& Impact);
+
+	UFUNCTION(Server, Unreliable)
+	void ServerRequestClockSync(double ClientSendTime);
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveClockSync(double ClientSendTime, double ServerTime);
+
+	/** Larger batches are split, so a single lost packet doesn't drop too many snapshots */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	int32 MaxSnapshotsPerBatch = 32;
+
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	bool bUseDeltaCompression = true;
+
+	/** Playout delay covers this many times the measured jitter */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator")
+	float PlayoutJitterMultiplier = FMotionJitterEstimator::DefaultJitterMultiplier;
+
+	/** Seconds between two clock sync exchanges */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Clock")
+	float ClockSyncInterval = 1.0f;
+	/** Used until the clock filter is filled, so the clock converges quickly after joining */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Clock")
+	float InitialClockSyncInterval = 0.1f;
+
+	/** Upper bound of snapshot bandwidth, in bytes per second */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Scheduling")
+	float MaxBytesPerSecond = 16000.0f;
+	/** Share of the connection net speed snapshots may take */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Scheduling", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float NetSpeedFraction = 0.5f;
+	/** Unused budget is carried over for at most this long */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Scheduling")
+	float MaxBurstTime = 0.1f;
+	/** Speed that doubles the send priority */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Scheduling")
+	float PriorityVelocity = 200.0f;
+	/** Angular speed that doubles the send priority */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Scheduling")
+	float PriorityAngularVelocity = 360.0f;
+	/** Priority starts to fall off with distance to the viewer past this */
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Scheduling")
+	float PriorityDistance = 500.0f;
+	UPROPERTY(EditAnywhere, Category = "MotionInterpolator|Scheduling", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float MinDistancePriority = 0.1f;
+
+private:
+	struct FScheduledSnapshot
+	{
+		FMotionSnapshot Snapshot;
+		/** Timestamp of the last snapshot sent for this id, samples are spaced from it */
+		double LastSentTimestamp = 0.0;
+		float Priority = 0.0f;
+		bool bPending = false;
+	};
+
+	void FlushPendingSnapshots(float DeltaTime);
+	void UpdateClockSync(float DeltaTime);
+	float GetBytesPerSecond() const;
+	float GetPriorityGain(const UMotionInterpolatorComponent& Interpolator, const FMotionSnapshot& Snapshot) const;
+	void SendBatch(const FMotionSnapshotBatch& Batch);
+	void EncodeEntry(uint16 NetId, const FMotionSnapshot& Snapshot, FMotionSnapshotBatchEntry& OutEntry);
+	/** Resolves deltas against the received history, returns false if the baseline is gone. Dequantizing is left to the subsystem's decode tasks */
+	bool DecodeEntry(const FMotionSnapshotBatchEntry& Entry, FQuantizedMotionSnapshot& OutQuantized);
+	void ReceiveBatch(const FMotionSnapshotBatch& Batch);
+	void ProcessAck(const FMotionSnapshotAck& Ack);
+	/** Both sides quantize with the precision of the addressed interpolator */
+	FMotionSnapshotPrecision GetSnapshotPrecision(uint16 NetId) const;
+	class UMotionInterpolatorSubsystem* GetSubsystem() const;
+
+	TMap<uint16, FScheduledSnapshot> ScheduledSnapshots;
+	int32 NumPendingSnapshots = 0;
+	/** Bits left this frame, negative while in debt */
+	float BudgetBits = 0.0f;
+	TArray<TPair<float, uint16>> SendCandidates;
+
+	TArray<FVector, TInlineAllocator<2>> InterestPoints;
+
+	TMap<uint16, FMotionJitterEstimator> JitterEstimators;
+	float ClockSyncTimer = 0.0f;
+	/** Newest received sequence per net id, not yet acked */
+	TMap<uint16, uint16> PendingAcks;
+
+	TMap<uint16, FMotionSnapshotSendStream> SendStreams;
+	TMap<uint16, FMotionSnapshotReceiveStream> ReceiveStreams;
+
+	/** Newest decode task of batches received through this channel, the next one waits for it */
+	FGraphEventRef LastDecodeTask;
+};
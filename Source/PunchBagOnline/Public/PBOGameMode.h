@@ -10,4 +10,6 @@ class PUNCHBAGONLINE_API APBOGameMode : public AGameModeBase
 	GENERATED_BODY()
 public:
 	APBOGameMode();
+
+	virtual void PostLogin(APlayerController* NewPlayer) override;
 };
@@ -13,4 +13,19 @@ public:
 	/** Returns the simulated TimeSeconds on the server, will be synchronized on client and server */
 	/** ping is added */
 	virtual float GetServerWorldTimeSeconds() const override;
+
+	/** Synchronized clock of UMotionInterpolatorSubsystem, the same on client and server. Not game time, it keeps running while paused or dilated */
+	double GetSyncedTimeSeconds() const;
+	/** Synced time minus game time on the server, puts GetServerWorldTimeSeconds on the synced timeline before a client's first clock sync */
+	double GetSyncedClockOffset() const { return SyncedClockOffset; }
+
+	virtual void BeginPlay() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+protected:
+	virtual void UpdateServerTimeSeconds() override;
+
+	/** Refreshed along with the replicated server world time, game time drifts from the synced clock while paused or dilated */
+	UPROPERTY(Replicated)
+	double SyncedClockOffset = 0.0;
 };
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "PBOReplicationGraph.generated.h"
+
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+
+/** Which graph node an actor is added to */
+enum class EPBOActorRoute : uint8
+{
+	/** Handled by the per connection node, like player controllers */
+	NotRouted,
+	RelevantAllConnections,
+	/** Only replicated to the connection owning it, kept in that connection's owner only node */
+	OnlyRelevantToOwner,
+	/** Never moves, like level geometry */
+	Spatialize_Static,
+	/** Moves all the time, like player VR pawns */
+	Spatialize_Dynamic,
+	/** Treated as static while dormant, like punching bags and props driven by UMotionInterpolatorComponent::bDriveNetDormancy */
+	Spatialize_Dormancy
+};
+
+/**
+ * Replication graph of the project, so the server doesn't consider every synced actor for every connection each frame.
+ * Actors are spatialized into a 2D grid, cells outside a connection's view aren't looked at.
+ * Punching bags and props that drive their dormancy are gathered as static actors while they rest.
+ * Owner only actors are kept in a node of their owning connection, and move along when the owner changes.
+ * Actors with a motion interpolator are culled at the subsystem's InterestRadius, so actor replication and snapshot forwarding agree.
+ */
+UCLASS(Transient, Config = Engine)
+class PUNCHBAGONLINE_API UPBOReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void ResetGameWorldState() override;
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	UPROPERTY(Config)
+	float GridCellSize = 5000.0f;
+
+	/** Lowest world coordinates of the grid, actors below are clamped to the first cells */
+	UPROPERTY(Config)
+	FVector2D SpatialBias = FVector2D(-100000.0f, -100000.0f);
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode = nullptr;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode = nullptr;
+
+	/** Owner only actors of each connection, the nodes are owned by the connection managers */
+	UPROPERTY()
+	TMap<UNetConnection*, UReplicationGraphNode_ActorList*> OwnerOnlyNodes;
+
+private:
+	EPBOActorRoute GetActorRoute(const AActor* Actor) const;
+
+	/** Adds an owner only actor to the node of its owning connection, false while it has none */
+	bool AddOwnerOnlyActor(const FNewReplicatedActorInfo& ActorInfo);
+	/** Moves owner only actors whose owner changed, and adds the ones that got an owner since */
+	void UpdateOwnerOnlyActors();
+
+	/** Routes can change with the actor's components, removals go to the node the actor was added to */
+	TMap<TObjectKey<AActor>, EPBOActorRoute> ActorRoutes;
+
+	/** Connection whose owner only node each owner only actor is in */
+	TMap<TObjectKey<AActor>, TWeakObjectPtr<UNetConnection>> OwnerOnlyActorConnections;
+	/** Owner only actors without an owning connection yet, owners are often set after spawning */
+	TArray<TWeakObjectPtr<AActor>> PendingOwnerOnlyActors;
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-capacity circular store of timestamped elements kept sorted by Timestamp.
+ * In-order inserts are O(1), lookups by time are O(log n). Late (out-of-order) elements
+ * are inserted at their sorted position, elements older than the whole buffer are dropped when it is full.
+ * ElementType must expose a double-comparable Timestamp member.
+ * Over-aligned element types need a matching allocator, like TAlignedHeapAllocator.
+ */
+template<typename ElementType, typename AllocatorType = FDefaultAllocator>
+class TSnapshotRingBuffer
+{
+public:
+	TSnapshotRingBuffer(int32 InCapacity = 0)
+	{
+		SetCapacity(InCapacity);
+	}
+
+	/** Changes the capacity, keeping the newest elements */
+	void SetCapacity(int32 InCapacity)
+	{
+		InCapacity = FMath::Max(InCapacity, 1);
+		if (InCapacity == Elements.Num())
+		{
+			return;
+		}
+
+		TArray<ElementType, AllocatorType> NewElements;
+		NewElements.SetNum(InCapacity);
+		const int32 NewCount = FMath::Min(Count, InCapacity);
+		for (int32 i = 0; i < NewCount; ++i)
+		{
+			NewElements[i] = (*this)[Count - NewCount + i];
+		}
+		Elements = MoveTemp(NewElements);
+		Head = 0;
+		Count = NewCount;
+	}
+
+	/**
+	 * Inserts the element at its sorted position.
+	 * An element with the same timestamp replaces the stored one.
+	 * Returns false if the element is older than everything in a full buffer and was dropped.
+	 */
+	bool Add(const ElementType& Element)
+	{
+		return Add(Element, [](const ElementType&) {});
+	}
+
+	/** Add that calls OnRemoved with the element pushed out or replaced by the new one, for elements owning external storage */
+	template<typename RemovedFunctorType>
+	bool Add(const ElementType& Element, RemovedFunctorType&& OnRemoved)
+	{
+		// common case, element is the newest one
+		if (Count == 0 || Last().Timestamp < Element.Timestamp)
+		{
+			if (Count == Capacity())
+			{
+				OnRemoved(First());
+				PopFirst();
+			}
+			GetMutable(Count) = Element;
+			++Count;
+			return true;
+		}
+
+		const int32 InsertIndex = LowerBound(Element.Timestamp);
+		if (InsertIndex < Count && (*this)[InsertIndex].Timestamp == Element.Timestamp)
+		{
+			OnRemoved((*this)[InsertIndex]);
+			GetMutable(InsertIndex) = Element;
+			return true;
+		}
+		if (Count == Capacity())
+		{
+			if (InsertIndex == 0)
+			{
+				return false;
+			}
+			OnRemoved(First());
+			PopFirst();
+			return InsertAt(InsertIndex - 1, Element);
+		}
+		return InsertAt(InsertIndex, Element);
+	}
+
+	void Empty()
+	{
+		Head = 0;
+		Count = 0;
+	}
+
+	void PopFirst()
+	{
+		if (Count > 0)
+		{
+			Head = (Head + 1) % Capacity();
+			--Count;
+		}
+	}
+
+	/** Drops every element with Timestamp >= Time */
+	void RemoveFrom(double Time)
+	{
+		Count = LowerBound(Time);
+	}
+
+	/** Index of the first element with Timestamp >= Time, Num() if there is none */
+	int32 LowerBound(double Time) const
+	{
+		int32 Low = 0;
+		int32 High = Count;
+		while (Low < High)
+		{
+			const int32 Middle = Low + (High - Low) / 2;
+			if ((*this)[Middle].Timestamp < Time)
+			{
+				Low = Middle + 1;
+			}
+			else
+			{
+				High = Middle;
+			}
+		}
+		return Low;
+	}
+
+	/** Index of the first element with Timestamp > Time, Num() if there is none */
+	int32 UpperBound(double Time) const
+	{
+		int32 Low = 0;
+		int32 High = Count;
+		while (Low < High)
+		{
+			const int32 Middle = Low + (High - Low) / 2;
+			if ((*this)[Middle].Timestamp <= Time)
+			{
+				Low = Middle + 1;
+			}
+			else
+			{
+				High = Middle;
+			}
+		}
+		return Low;
+	}
+
+	/** Copies elements from oldest to newest */
+	template<typename OutAllocatorType>
+	void ToArray(TArray<ElementType, OutAllocatorType>& OutElements) const
+	{
+		OutElements.Reset(Count);
+		for (int32 i = 0; i < Count; ++i)
+		{
+			OutElements.Add((*this)[i]);
+		}
+	}
+
+	/** Element by logical index, 0 is the oldest one */
+	FORCEINLINE const ElementType& operator[](int32 Index) const
+	{
+		checkSlow(Index >= 0 && Index < Count);
+		return Elements[(Head + Index) % Capacity()];
+	}
+
+	FORCEINLINE const ElementType& First() const { return (*this)[0]; }
+	FORCEINLINE const ElementType& Last() const { return (*this)[Count - 1]; }
+	FORCEINLINE int32 Num() const { return Count; }
+	FORCEINLINE bool IsEmpty() const { return Count == 0; }
+	FORCEINLINE int32 Capacity() const { return Elements.Num(); }
+	SIZE_T GetAllocatedSize() const { return Elements.GetAllocatedSize(); }
+
+private:
+	FORCEINLINE ElementType& GetMutable(int32 Index)
+	{
+		return Elements[(Head + Index) % Capacity()];
+	}
+
+	bool InsertAt(int32 Index, const ElementType& Element)
+	{
+		check(Count < Capacity());
+		for (int32 i = Count; i > Index; --i)
+		{
+			GetMutable(i) = GetMutable(i - 1);
+		}
+		GetMutable(Index) = Element;
+		++Count;
+		return true;
+	}
+
+	TArray<ElementType, AllocatorType> Elements;
+	int32 Head = 0;
+	int32 Count = 0;
+};
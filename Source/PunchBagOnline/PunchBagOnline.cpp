@@ -1,6 +1,47 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "PunchBagOnline.h"
+#include "MotionInterpolatorStats.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogMotionInterpolator);
+
+DEFINE_STAT(STAT_MotionInterp_BatchTick);
+DEFINE_STAT(STAT_MotionInterp_ComponentTick);
+DEFINE_STAT(STAT_MotionInterp_Lookups);
+DEFINE_STAT(STAT_MotionInterp_FlushSnapshots);
+DEFINE_STAT(STAT_MotionInterp_ReceiveBatch);
+DEFINE_STAT(STAT_MotionInterp_DecodeSnapshots);
+DEFINE_STAT(STAT_MotionInterp_PhysicsTargets);
+DEFINE_STAT(STAT_MotionInterp_HitValidation);
+DEFINE_STAT(STAT_MotionInterp_SnapshotsSent);
+DEFINE_STAT(STAT_MotionInterp_SnapshotsReceived);
+DEFINE_STAT(STAT_MotionInterp_BatchedSnapshotsSent);
+DEFINE_STAT(STAT_MotionInterp_BatchedBitsSent);
+DEFINE_STAT(STAT_MotionInterp_BitsPerSnapshot);
+DEFINE_STAT(STAT_MotionInterp_Extrapolations);
+DEFINE_STAT(STAT_MotionInterp_PhysicsTargetsApplied);
+DEFINE_STAT(STAT_MotionInterp_Underruns);
+DEFINE_STAT(STAT_MotionInterp_StaleEpochSnapshots);
+DEFINE_STAT(STAT_MotionInterp_HitsValidated);
+DEFINE_STAT(STAT_MotionInterp_DormancySleeps);
+DEFINE_STAT(STAT_MotionInterp_DormancyWakes);
+DEFINE_STAT(STAT_MotionInterp_ImpactsSent);
+DEFINE_STAT(STAT_MotionInterp_ImpactsReceived);
+DEFINE_STAT(STAT_MotionInterp_ImpactsRejected);
+DEFINE_STAT(STAT_MotionInterp_Interpolators);
+DEFINE_STAT(STAT_MotionInterp_NetworkDelayAvg);
+DEFINE_STAT(STAT_MotionInterp_NetworkDelayMax);
+DEFINE_STAT(STAT_MotionInterp_AdditionalDelayAvg);
+DEFINE_STAT(STAT_MotionInterp_BufferOccupancy);
+DEFINE_STAT(STAT_MotionInterp_OwnershipHandoffs);
+DEFINE_STAT(STAT_MotionInterp_SleepingInterpolators);
+DEFINE_STAT(STAT_MotionInterp_HandoffReleaseTime);
+DEFINE_STAT(STAT_MotionInterp_RewindHistoryMemory);
+DEFINE_STAT(STAT_MotionInterp_SnapshotBufferMemory);
+
+CSV_DEFINE_CATEGORY_MODULE(PUNCHBAGONLINE_API, MotionInterp, true);
+
+UE_TRACE_CHANNEL_DEFINE(MotionInterpChannel);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, PunchBagOnline, "PunchBagOnline" );